@@ -0,0 +1,111 @@
+#pragma once
+
+// Heap allocation counting, for builds with SPACESHIP_COUNT_ALLOCATIONS
+// defined (-DSPACESHIP_COUNT_ALLOCATIONS). Such a build replaces the global
+// operator new and delete with versions that count every allocation before
+// handing it to malloc, so a benchmark can check that its steady-state
+// frames never touch the heap. The count covers every thread, and C++ code
+// inside the GL driver too: llvmpipe's shader compiler allocates through
+// operator new the first time a frame draws with a new combination of
+// state. Plain malloc calls are not seen.
+//
+// Other builds keep the standard operators, so normal play pays nothing,
+// and heapAllocationsCounted() says there is no count to read.
+//
+// The replacements are ordinary function definitions, so this header may
+// only be included from one translation unit per program. Each program
+// here is built from a single one.
+
+#include <cstdint>
+
+#ifndef SPACESHIP_COUNT_ALLOCATIONS
+
+inline bool heapAllocationsCounted() {
+    return false;
+}
+
+inline uint64_t heapAllocations() {
+    return 0;
+}
+
+#else
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<uint64_t>& heapAllocationCounter() {
+    static std::atomic<uint64_t> count{ 0 };
+    return count;
+}
+
+inline bool heapAllocationsCounted() {
+    return true;
+}
+
+// Allocations since the program started
+inline uint64_t heapAllocations() {
+    return heapAllocationCounter().load(std::memory_order_relaxed);
+}
+
+inline void* countedAllocation(size_t size) {
+    heapAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+// GCC sees this free() inlined into code that got its pointer from
+// operator new, and takes it for a mismatched pair
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+inline void releaseAllocation(void* memory) {
+    free(memory);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+void* operator new(size_t size) {
+    if (void* memory = countedAllocation(size)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* memory = countedAllocation(size)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocation(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocation(size);
+}
+
+void operator delete(void* memory) noexcept {
+    releaseAllocation(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    releaseAllocation(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    releaseAllocation(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    releaseAllocation(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    releaseAllocation(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    releaseAllocation(memory);
+}
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+// Interface the arcade menu uses to host the games in its own process and
+// GL context. Each game's source also builds as a standalone program;
+// defining SPACESHIP_ARCADE_HOST before including it leaves out its main().
+
+#include <cstdint>
+
+class ArcadeGame {
+public:
+    virtual ~ArcadeGame() {}
+
+    virtual const char* title() const = 0;
+
+    // Becoming the active scene: set up GL state and start a fresh game.
+    // Meshes, shaders and the glyph atlas come from shared caches, so only
+    // the first call pays for building them.
+    virtual void init(uint64_t seed) = 0;
+
+    // One fixed simulation tick
+    virtual void update(float deltaTime) = 0;
+
+    // Runs the ticks on a thread of the game's own instead, at the fixed
+    // rate, until shutdown(). update() must not be called meanwhile, and
+    // render() places the scene by that thread's clock instead of `alpha`.
+    virtual void startSimulationThread() = 0;
+
+    // Draws the scene `alpha` (0..1) of the way from the previous tick to
+    // the current one; `time` is real seconds for cosmetic animation. The
+    // caller swaps buffers.
+    virtual void render(float alpha, float time) = 0;
+
+    // The caller swaps buffers, then reports it here
+    virtual void framePresented() = 0;
+
+    // Whether the next frame would differ from the one on screen. A paused
+    // or finished game says no, and the caller stops asking it to render
+    // until it says yes again; a redraw the window system asks for still
+    // comes through, and the game blits its cached frame.
+    virtual bool needsRedraw() = 0;
+
+    virtual void reshape(int width, int height) = 0;
+    virtual void keyDown(unsigned char key) = 0;
+    virtual void specialKeyDown(int key) = 0;
+    virtual void keyUp(unsigned char key) = 0;
+    virtual void specialKeyUp(int key) = 0;
+
+    // Leaving the scene: persist anything worth keeping
+    virtual void shutdown() = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+// Minimal "--name value" command-line lookups shared by the programs.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+inline bool hasArg(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+// Value following `name`, or `fallback` when absent
+inline const char* argValue(int argc, char** argv, const char* name, const char* fallback = nullptr) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    }
+    return fallback;
+}
+
+inline long argLong(int argc, char** argv, const char* name, long fallback) {
+    const char* value = argValue(argc, argv, name);
+    return value ? strtol(value, nullptr, 10) : fallback;
+}
+
+inline uint64_t argUint64(int argc, char** argv, const char* name, uint64_t fallback) {
+    const char* value = argValue(argc, argv, name);
+    return value ? strtoull(value, nullptr, 10) : fallback;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+// Structure-of-arrays entity storage.
+// Each kind of entity keeps every field in a contiguous column of its own,
+// so an update loop streams through only the fields it touches and the
+// compiler can vectorise it. Entities stay densely packed: removing one
+// moves the last entity into its place (swap-and-pop), so removal is O(1)
+// but reorders the dense indices. An EntityHandle stays valid across that.
+// It names a slot that tracks where its entity currently sits, plus the
+// slot's generation, which is bumped when the entity is removed; a handle
+// to a removed entity is then stale instead of naming whatever reused the
+// slot.
+//
+// A kind's store derives from EntityStore<Store> and lists its columns in
+// forEachColumn(); the base keeps them and the slots in step.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct EntityHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+// Slots and generations for one kind of entity
+class EntityIndex {
+public:
+    // Sets aside room so that up to `capacity` live entities never allocate
+    void reserve(size_t capacity) {
+        denseSlots.reserve(capacity);
+        slotIndices.reserve(capacity);
+        generations.reserve(capacity);
+        freeSlots.reserve(capacity);
+    }
+
+    size_t size() const {
+        return denseSlots.size();
+    }
+
+    // Registers an entity at dense index size()
+    EntityHandle add() {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = (uint32_t)generations.size();
+            generations.push_back(0);
+            slotIndices.push_back(0);
+        }
+        slotIndices[slot] = (uint32_t)denseSlots.size();
+        denseSlots.push_back(slot);
+        return handle(slot);
+    }
+
+    // Frees the entity at `index` and moves the last one into its place
+    void remove(size_t index) {
+        uint32_t slot = denseSlots[index];
+        generations[slot]++;
+        freeSlots.push_back(slot);
+        uint32_t last = denseSlots.back();
+        denseSlots[index] = last;
+        slotIndices[last] = (uint32_t)index;
+        denseSlots.pop_back();
+    }
+
+    void clear() {
+        for (uint32_t slot : denseSlots) {
+            generations[slot]++;
+            freeSlots.push_back(slot);
+        }
+        denseSlots.clear();
+    }
+
+    bool alive(EntityHandle entity) const {
+        return entity.slot < generations.size() && generations[entity.slot] == entity.generation;
+    }
+
+    // Dense index of a live entity
+    size_t indexOf(EntityHandle entity) const {
+        return slotIndices[entity.slot];
+    }
+
+    EntityHandle handleAt(size_t index) const {
+        return handle(denseSlots[index]);
+    }
+
+private:
+    std::vector<uint32_t> denseSlots;  // slot of each dense index
+    std::vector<uint32_t> slotIndices; // dense index of each live slot
+    std::vector<uint32_t> generations; // bumped each time a slot is freed
+    std::vector<uint32_t> freeSlots;
+
+    EntityHandle handle(uint32_t slot) const {
+        EntityHandle entity;
+        entity.slot = slot;
+        entity.generation = generations[slot];
+        return entity;
+    }
+};
+
+// Store supplies forEachColumn(visit), calling visit(column) for each of
+// its std::vector columns
+template <typename Store>
+class EntityStore {
+public:
+    size_t size() const {
+        return index.size();
+    }
+
+    bool empty() const {
+        return index.size() == 0;
+    }
+
+    void reserve(size_t capacity) {
+        index.reserve(capacity);
+        store().forEachColumn([capacity](auto& column) { column.reserve(capacity); });
+    }
+
+    // Swap-and-pop: the last entity takes dense index `i`
+    void remove(size_t i) {
+        store().forEachColumn([i](auto& column) {
+            column[i] = column.back();
+            column.pop_back();
+        });
+        index.remove(i);
+    }
+
+    void clear() {
+        store().forEachColumn([](auto& column) { column.clear(); });
+        index.clear();
+    }
+
+    bool alive(EntityHandle entity) const {
+        return index.alive(entity);
+    }
+
+    size_t indexOf(EntityHandle entity) const {
+        return index.indexOf(entity);
+    }
+
+    EntityHandle handleAt(size_t i) const {
+        return index.handleAt(i);
+    }
+
+protected:
+    // For Store's add(), which pushes one value onto every column
+    EntityHandle addEntity() {
+        return index.add();
+    }
+
+private:
+    EntityIndex index;
+
+    Store& store() {
+        return static_cast<Store&>(*this);
+    }
+};
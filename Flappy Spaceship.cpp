@@ -1,195 +1,262 @@
 #include <GL/glut.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <fstream>
+#include "ArcadeGame.h"
+#include "CommandLine.h"
+#include "FrameCache.h"
+#include "FrameClock.h"
+#include "InstancedRenderer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "RenderBenchmark.h"
+#include "RenderQueue.h"
+#include "Replay.h"
+#include "RingBuffer.h"
+#include "ScoreStore.h"
+#include "SimulationThread.h"
+#include "Starfield.h"
+#include "TextRenderer.h"
+
+namespace flappy {
 
 const int NUM_STARS = 1000;
-float movementSpeed = 0.1f;
+float movementSpeed = 6.0f; // units per second
 
-struct Star {
-    float x, y, z;
-    float brightness;
-    float speed;
-};
+// Simulation runs at a fixed 60 Hz; rendering interpolates between ticks
+FrameClock frameClock(60.0);
+float renderAlpha = 1.0f;  // 0..1 between the previous and current tick
+float renderTime = 0.0f;   // seconds, sampled once per frame
+
+Starfield starfield;
 
-Star stars[NUM_STARS];
+// Random streams, all derived from gameSeed in seedRandom()
+uint64_t gameSeed = timeSeed(); // --seed S
+RandomStream starRng;
+RandomStream pipeRng;
+RandomStream inputRng; // scripted input in headless runs
+
+void seedRandom(uint64_t seed) {
+    gameSeed = seed;
+    starRng.seed(seed, 0);
+    pipeRng.seed(seed, 1);
+    inputRng.seed(seed, 2);
+}
 
 // Spaceship variables 
 float shipX = -5.0f, shipY = 0.0f, shipZ = -10.0f;
-float shipVelocity = 0.0f;
-float gravity = -0.005f;
+float prevShipY = 0.0f;
+float shipVelocity = 0.0f;  // units per second
+float gravity = -18.0f;     // units per second squared
+float boostVelocity = 4.8f;
+float pipeSpeed = 6.0f;      // --pipe-speed
+float pipeSpacing = 10.0f;  // distance between pipes, --pipe-spacing
 bool gameOver = false;
 bool gamePaused = false;
 
+const float PIPE_SPAWN_X = 20.0f;
+const float PIPE_DESPAWN_X = -20.0f;
+const float MIN_PIPE_SPACING = 1.0f; // keeps the whole course within MAX_PIPES
+const size_t MAX_PIPES = 64;
+
 struct Pipe {
     float x;
     float gapY;
     float gapSize = 6.0f;
+    float prevX = PIPE_SPAWN_X; // x at the previous tick
 };
 
-std::vector<Pipe> pipes;
+// Pipe course, oldest first. nextPipe indexes the first pipe that has not
+// yet cleared the ship's collision window; it is the only one that can hit.
+RingBuffer<Pipe, MAX_PIPES> pipes;
+size_t nextPipe = 0;
 int score = 0;
-int highScore = 0;
+int highScore = 0;          // best this session; the leaderboard keeps the rest
+bool scoreRecorded = false; // this game's score has gone to the leaderboard
 
-const char* HIGH_SCORE_FILE = "highscore.dat";
+const char* GAME_TITLE = "Flappy Spaceship";
+const char* LEGACY_HIGH_SCORE_FILE = "highscore.dat"; // imported once into SCORE_FILE
+bool persistHighScore = true; // off for headless runs
 
-// Helper: render text to screen
-void renderBitmapString(float x, float y, void* font, const char* string) {
-    glRasterPos2f(x, y);
-    while (*string) {
-        glutBitmapCharacter(font, *string);
-        ++string;
-    }
-}
+// Everything render() reads from the simulation, copied after each batch of
+// ticks, so the render thread never reads state the simulation thread is
+// changing
+struct SceneSnapshot {
+    double time = 0.0; // SimulationThread::tickTime() the state is current at
+    float shipY = 0.0f, prevShipY = 0.0f;
+    RingBuffer<Pipe, MAX_PIPES> pipes;
+    double starTicks = 0.0;
+    int score = 0, highScore = 0;
+    bool gameOver = false, gamePaused = false;
+    uint32_t stillFrame = 0; // see stillFrameId()
+};
+SnapshotBuffer<SceneSnapshot> snapshots;
+const SceneSnapshot* scene = nullptr; // the snapshot render() is drawing
+SimulationThread simulation;          // unless --no-sim-thread
+SpscQueue<KeyInput, 64> keyPresses;   // from the GLUT callbacks to the next tick
+FrameCache frameCache;                // the last still frame; see FrameCache.h
+std::atomic<uint32_t> latestStillFrame{ 0 }; // stillFrame of the newest snapshot
+bool cacheStillFrames = true;         // off for the render benchmark, which draws every frame
 
-void loadHighScore() {
-    std::ifstream file(HIGH_SCORE_FILE, std::ios::binary);
-    if (file.is_open()) {
-        file.read(reinterpret_cast<char*>(&highScore), sizeof(highScore));
-        file.close();
-    }
+// Geometry tessellated once by initMeshes(); round parts at every LOD level
+struct SceneMeshes {
+    LodMesh planet;
+    LodMesh hull;
+    LodMesh dome;
+    LodMesh sideLight;
+    LodMesh flameGlow;
+    LodMesh flameCone;
+    const Mesh* pipe;
+};
+SceneMeshes meshes;
+InstanceBatch pipeBatch;
+const float FLAME_HEIGHT = 0.4f;
+
+void initMeshes() {
+    MeshCache& cache = meshCache();
+    meshes.planet = cache.sphereLod(8.0f, 100, 100);
+    meshes.hull = cache.sphereLod(1.0f, 50, 50);
+    meshes.dome = cache.sphereLod(0.6f, 30, 30);
+    meshes.sideLight = cache.sphereLod(0.15f, 20, 20);
+    meshes.flameGlow = cache.sphereLod(0.2f, 20, 20);
+    meshes.flameCone = cache.coneLod(0.2f, FLAME_HEIGHT, 20, 20);
+    meshes.pipe = &cache.cube(1.0f);
+    pipeBatch.reserve(2 * MAX_PIPES); // a top and a bottom half per pipe
 }
 
-void saveHighScore() {
-    std::ofstream file(HIGH_SCORE_FILE, std::ios::binary);
+// The single native-endian int the game saved before the shared score file
+int readLegacyHighScore() {
+    int legacy = 0;
+    std::ifstream file(LEGACY_HIGH_SCORE_FILE, std::ios::binary);
     if (file.is_open()) {
-        file.write(reinterpret_cast<const char*>(&highScore), sizeof(highScore));
+        file.read(reinterpret_cast<char*>(&legacy), sizeof(legacy));
         file.close();
     }
+    return legacy;
 }
 
-void drawTextOverlay() {
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, 800, 0, 600);
+// Starts loading the leaderboard; it arrives in the background
+void loadHighScore() {
+    if (persistHighScore) scoreStore().open(SCORE_FILE, GAME_TITLE, readLegacyHighScore);
+}
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+// Hands the current game's score to the leaderboard, once per game. The
+// store saves it on its own thread, so this is safe on the game-over path.
+void recordScore() {
+    if (scoreRecorded) return;
+    scoreRecorded = true;
+    highScore = std::max(highScore, score);
+    if (persistHighScore) scoreStore().submit(GAME_TITLE, score);
+}
 
-    glDisable(GL_LIGHTING);
-    glColor3f(1.0f, 1.0f, 1.0f);
+// The overlay is laid out on an 800x600 canvas stretched over the window
+const float OVERLAY_WIDTH = 800.0f, OVERLAY_HEIGHT = 600.0f;
+TextBatch overlay;
+int overlayScore, overlayHighScore, overlayPaused, overlayResume, overlayGameOver, overlayRestart;
+int windowWidth = 800, windowHeight = 600; // kept by reshape()
 
-    std::string scoreText = "Score: " + std::to_string(score);
-    renderBitmapString(10, 570, GLUT_BITMAP_HELVETICA_18, scoreText.c_str());
+void initTextOverlay() {
+    if (overlay.lineCount() > 0) return; // set up by an earlier session
+    glyphAtlas(GLUT_BITMAP_HELVETICA_18);
+    overlayScore = overlay.addLine();
+    overlayHighScore = overlay.addLine();
+    overlayPaused = overlay.addLine();
+    overlayResume = overlay.addLine();
+    overlayGameOver = overlay.addLine();
+    overlayRestart = overlay.addLine();
+}
 
-    std::string highScoreText = "High Score: " + std::to_string(highScore);
-    renderBitmapString(10, 540, GLUT_BITMAP_HELVETICA_18, highScoreText.c_str());
+void drawTextOverlay() {
+    GpuProfileZone zone("HUD");
+    float sx = windowWidth / OVERLAY_WIDTH;
+    float sy = windowHeight / OVERLAY_HEIGHT;
 
-    if (gamePaused) {
-        renderBitmapString(350, 300, GLUT_BITMAP_HELVETICA_18, "PAUSED");
-        renderBitmapString(300, 270, GLUT_BITMAP_HELVETICA_18, "Press P to resume");
-    }
+    overlay.setNumber(overlayScore, 10 * sx, 570 * sy, "Score: ", scene->score);
+    overlay.setNumber(overlayHighScore, 10 * sx, 540 * sy, "High Score: ", std::max(scene->highScore, scoreStore().best(GAME_TITLE)));
 
-    if (gameOver) {
-        renderBitmapString(300, 300, GLUT_BITMAP_HELVETICA_18, "Game Over!");
-        renderBitmapString(250, 270, GLUT_BITMAP_HELVETICA_18, "Press any key to restart...");
-    }
+    overlay.setText(overlayPaused, 350 * sx, 300 * sy, "PAUSED");
+    overlay.setText(overlayResume, 300 * sx, 270 * sy, "Press P to resume");
+    overlay.setVisible(overlayPaused, scene->gamePaused);
+    overlay.setVisible(overlayResume, scene->gamePaused);
 
-    glEnable(GL_LIGHTING);
+    overlay.setText(overlayGameOver, 300 * sx, 300 * sy, "Game Over!");
+    overlay.setText(overlayRestart, 250 * sx, 270 * sy, "Press any key to restart...");
+    overlay.setVisible(overlayGameOver, scene->gameOver);
+    overlay.setVisible(overlayRestart, scene->gameOver);
 
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
+    overlay.draw(windowWidth, windowHeight);
 }
 
 void initializeStars() {
-    std::srand(std::time(0));
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].x = (std::rand() % 2000 - 1000) / 100.0f;
-        stars[i].y = (std::rand() % 2000 - 1000) / 100.0f;
-        stars[i].z = (std::rand() % 1000) / -10.0f - 1.0f;
-        stars[i].brightness = (std::rand() % 100) / 100.0f * 0.5f + 0.5f;
-        stars[i].speed = movementSpeed * (0.5f + stars[i].brightness);
-    }
-    pipes.push_back({ 20.0f, 0.0f });
+    seedRandom(gameSeed);
+    starfield.init(NUM_STARS, -100.0f, movementSpeed, starRng);
+    pipes.push_back({ PIPE_SPAWN_X, 0.0f });
     loadHighScore();
 }
 
-void updateStars() {
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].z += stars[i].speed;
-        if (stars[i].z > 0.0f) {
-            stars[i].x = (std::rand() % 2000 - 1000) / 100.0f;
-            stars[i].y = (std::rand() % 2000 - 1000) / 100.0f;
-            stars[i].z = -100.0f;
-            stars[i].brightness = (std::rand() % 100) / 100.0f * 0.5f + 0.5f;
-            stars[i].speed = movementSpeed * (0.5f + stars[i].brightness);
-        }
-    }
-}
+// The draw functions below queue their geometry; render() draws it sorted
 
 void drawPlanet() {
-    GLfloat ambient[] = { 0.3f, 0.25f, 0.25f, 1.0f };
-    GLfloat diffuse[] = { 0.7f, 0.6f, 0.5f, 1.0f };
-    GLfloat specular[] = { 0.4f, 0.4f, 0.4f, 1.0f };
-    GLfloat shininess = 30.0f;
-
-    glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
-    glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
-
+    const float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; // lit by the material from setupLighting()
     glPushMatrix();
     glTranslatef(0.0f, -14.0f, -30.0f);
     glScalef(6.0f, 1.0f, 1.0f);
     glRotatef(25, 1, 0, 0);
-    glutSolidSphere(8.0, 100, 100);
+    renderQueue().add(meshes.planet, color);
     glPopMatrix();
 }
 
 void drawSpaceshipBase() {
+    const float color[4] = { 0.6f, 0.6f, 0.6f, 1.0f };
     glPushMatrix();
-    glColor3f(0.6f, 0.6f, 0.6f);
     glScalef(1.5f, 0.3f, 1.5f);
-    glutSolidSphere(1.0f, 50, 50);
+    renderQueue().add(meshes.hull, color);
     glPopMatrix();
 }
 
 void drawGlassDome() {
+    const float color[4] = { 0.3f, 0.7f, 1.0f, 0.5f };
     glPushMatrix();
     glTranslatef(0.0f, 0.3f, 0.0f);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.3f, 0.7f, 1.0f, 0.5f);
-    glutSolidSphere(0.6f, 30, 30);
-    glDisable(GL_BLEND);
+    renderQueue().add(meshes.dome, color, BLEND_ALPHA);
     glPopMatrix();
 }
 
 void drawSideLights() {
+    const float color[4] = { 1.0f, 0.9f, 0.0f, 1.0f };
     float positions[2] = { -0.9f, 0.9f };
     for (int i = 0; i < 2; i++) {
         glPushMatrix();
         glTranslatef(positions[i], -0.1f, 1.1f - fabs(positions[i]));
-        glColor3f(1.0f, 0.9f, 0.0f);
-        glutSolidSphere(0.15f, 20, 20);
+        renderQueue().add(meshes.sideLight, color);
         glPopMatrix();
     }
 }
 
 void drawThrusterFlame(float offsetX) {
+    const float glowColor[4] = { 1.0f, 0.3f, 0.0f, 0.2f };
+    const float flameColor[4] = { 1.0f, 0.4f, 0.0f, 1.0f };
     glPushMatrix();
     glTranslatef(offsetX, 0.01f, 1.7f);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glColor4f(1.0f, 0.3f, 0.0f, 0.2f);
-    glutSolidSphere(0.2f, 20, 20);
-    glDisable(GL_BLEND);
-    glColor3f(1.0f, 0.4f, 0.0f);
+    renderQueue().add(meshes.flameGlow, glowColor, BLEND_ADDITIVE);
     glRotatef(180, 1, 0, 0);
-    float flameHeight = 0.4f + 0.05f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.001f);
-    glutSolidCone(0.2f, flameHeight, 20, 20);
+    float flameHeight = 0.4f + 0.05f * sin(renderTime);
+    glScalef(1.0f, 1.0f, flameHeight / FLAME_HEIGHT);
+    renderQueue().add(meshes.flameCone, flameColor);
     glPopMatrix();
 }
 
 void drawSpaceship() {
     glPushMatrix();
-    glTranslatef(shipX, shipY, shipZ);
+    glTranslatef(shipX, lerp(scene->prevShipY, scene->shipY, renderAlpha), shipZ);
 
     drawSpaceshipBase();
     drawGlassDome();
@@ -200,101 +267,156 @@ void drawSpaceship() {
     glPopMatrix();
 }
 
+// Every pipe segment is an instance of the unit cube, drawn in one call
 void drawPipes() {
-    glColor3f(0.2f, 1.0f, 0.2f);
-    for (Pipe& pipe : pipes) {
-        glPushMatrix();
-        glTranslatef(pipe.x, 0.0f, -10.0f);
+    float topY = 10.0f;
+    float bottomY = -10.0f;
 
-        float topY = 10.0f;
-        float bottomY = -10.0f;
+    pipeBatch.clear();
+    for (size_t i = 0; i < scene->pipes.size(); i++) {
+        const Pipe& pipe = scene->pipes[i];
+        float x = lerp(pipe.prevX, pipe.x, renderAlpha);
+        float gapTop = pipe.gapY + pipe.gapSize / 2.0f;
+        float gapBottom = pipe.gapY - pipe.gapSize / 2.0f;
 
         // Top Pipe
-        glPushMatrix();
-        glTranslatef(0, pipe.gapY + pipe.gapSize / 2.0f + (topY - (pipe.gapY + pipe.gapSize / 2.0f)) / 2.0f, 0);
-        glScalef(1.0f, (topY - (pipe.gapY + pipe.gapSize / 2.0f)), 1.0f);
-        glutSolidCube(1.0);
-        glPopMatrix();
+        pipeBatch.add(x, gapTop + (topY - gapTop) / 2.0f, -10.0f, 0.0f, 1.0f, topY - gapTop, 1.0f);
 
         // Bottom Pipe
-        glPushMatrix();
-        glTranslatef(0, bottomY + ((pipe.gapY - pipe.gapSize / 2.0f) - bottomY) / 2.0f, 0);
-        glScalef(1.0f, ((pipe.gapY - pipe.gapSize / 2.0f) - bottomY), 1.0f);
-        glutSolidCube(1.0);
-        glPopMatrix();
+        pipeBatch.add(x, bottomY + (gapBottom - bottomY) / 2.0f, -10.0f, 0.0f, 1.0f, gapBottom - bottomY, 1.0f);
+    }
+    pipeBatch.upload();
 
-        glPopMatrix();
+    RenderQueue& queue = renderQueue();
+    queue.addBatch([] {
+        GpuProfileZone zone("pipes");
+        const float pipeColor[4] = { 0.2f, 1.0f, 0.2f, 1.0f };
+        pipeBatch.draw(*meshes.pipe, pipeColor);
+    }, queue.eyeDepth(0.0f, 0.0f, -10.0f), BLEND_OPAQUE);
+}
+
+void endGame() {
+    gameOver = true;
+    recordScore();
+}
+
+void boost() {
+    if (!gameOver && !gamePaused) {
+        shipVelocity = boostVelocity;
     }
 }
 
-void updateGame() {
+void restartGame() {
+    shipY = prevShipY = 0.0f;
+    shipVelocity = 0.0f;
+    pipes.clear();
+    pipes.push_back({ PIPE_SPAWN_X, 0.0f });
+    nextPipe = 0;
+    gameOver = false;
+    score = 0;
+    scoreRecorded = false;
+}
+
+void updateGame(float deltaTime) {
     if (gameOver || gamePaused) return;
 
-    shipVelocity += gravity;
-    shipY += shipVelocity;
+    prevShipY = shipY;
+    shipVelocity += gravity * deltaTime;
+    shipY += shipVelocity * deltaTime;
 
     // Add new pipe
-    if (pipes.empty() || pipes.back().x < 10.0f) {
-        float gapY = (std::rand() % 150 - 75) / 10.0f;
-        pipes.push_back({ 20.0f, gapY });
+    if (pipes.empty() || pipes.back().x < PIPE_SPAWN_X - pipeSpacing) {
+        float gapY = (pipeRng.range(150) - 75) / 10.0f;
+        pipes.push_back({ PIPE_SPAWN_X, gapY });
     }
 
     // Update pipes
-    for (Pipe& pipe : pipes) {
-        pipe.x -= 0.1f;
+    for (size_t i = 0; i < pipes.size(); i++) {
+        pipes[i].prevX = pipes[i].x;
+        pipes[i].x -= pipeSpeed * deltaTime;
+    }
 
-        if (pipe.x < -5.5f && pipe.x > -6.0f) {
+    // Only the pipe at the ship can collide
+    while (nextPipe < pipes.size() && pipes[nextPipe].x <= -6.0f) {
+        nextPipe++;
+    }
+    if (nextPipe < pipes.size()) {
+        const Pipe& pipe = pipes[nextPipe];
+        if (pipe.x < -5.5f) {
             if (shipY < pipe.gapY - pipe.gapSize / 2.0f || shipY > pipe.gapY + pipe.gapSize / 2.0f) {
-                gameOver = true;
-                if (score > highScore) {
-                    highScore = score;
-                    saveHighScore();
-                }
+                endGame();
             }
         }
     }
 
-    // Remove off-screen pipe
-    if (!pipes.empty() && pipes.front().x < -20.0f) {
-        pipes.erase(pipes.begin());
+    // Remove off-screen pipes
+    while (!pipes.empty() && pipes.front().x < PIPE_DESPAWN_X) {
+        pipes.pop_front();
+        if (nextPipe > 0) nextPipe--;
         score++;
     }
 
     // Out of bounds
     if (shipY < -10.0f || shipY > 10.0f) {
-        gameOver = true;
-        if (score > highScore) {
-            highScore = score;
-            saveHighScore();
-        }
+        endGame();
     }
 }
 
-void display() {
+void render(float alpha, float time) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
     gluLookAt(0, 0, 0, 0, 0, -1, 0, 1, 0);
 
-    glDisable(GL_LIGHTING);
-    glPointSize(2.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < NUM_STARS; ++i) {
-        glColor3f(stars[i].brightness, stars[i].brightness, stars[i].brightness);
-        glVertex3f(stars[i].x, stars[i].y, stars[i].z);
+    scene = &snapshots.acquire();
+    if (simulation.running()) alpha = simulation.alpha(scene->time);
+    bool still = scene->stillFrame != 0 && !profiler().overlayShown();
+    if (still && frameCache.holds(scene->stillFrame, windowWidth, windowHeight)) {
+        frameCache.draw();
+        return;
     }
-    glEnd();
 
-    glEnable(GL_LIGHTING);
-    drawPlanet();
-    drawSpaceship();
-    drawPipes();
+    // A frozen game has no next state to interpolate toward
+    renderAlpha = (scene->gameOver || scene->gamePaused) ? 1.0f : alpha;
+    renderTime = time;
+    GpuProfileZone renderZone("render");
+
+    RenderQueue& queue = renderQueue();
+    {
+        ProfileZone zone("submit");
+        queue.begin();
+        queue.addBatch([] {
+            GpuProfileZone zone("starfield");
+            starfield.draw(scene->starTicks);
+        }, queue.eyeDepth(0.0f, 0.0f, -100.0f), BLEND_OPAQUE);
+        drawPlanet();
+        drawSpaceship();
+        drawPipes();
+    }
+    {
+        GpuProfileZone zone("scene");
+        queue.flush();
+    }
 
     drawTextOverlay();
+    profiler().drawOverlay(windowWidth, windowHeight);
+    if (still) frameCache.capture(scene->stillFrame, windowWidth, windowHeight);
+}
+
+// False while the frame on screen is a still frame that is still current
+bool needsRedraw() {
+    return profiler().overlayShown()
+        || !frameCache.holds(latestStillFrame.load(std::memory_order_acquire), windowWidth, windowHeight);
+}
 
+void display() {
+    render(frameClock.alpha(), frameClock.time());
+    ProfileZone zone("swap");
     glutSwapBuffers();
 }
 
 void reshape(int width, int height) {
+    windowWidth = width;
+    windowHeight = height;
     glViewport(0, 0, width, height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -302,46 +424,165 @@ void reshape(int width, int height) {
     glMatrixMode(GL_MODELVIEW);
 }
 
-void animate(int value) {
-    if (!gamePaused) {
-        updateStars();
-        updateGame();
+void stepGame(float deltaTime) {
+    if (gamePaused) return;
+    {
+        ProfileZone zone("updateStars");
+        starfield.advance(deltaTime);
     }
-    glutPostRedisplay();
-    glutTimerFunc(16, animate, 0);
+    ProfileZone zone("updateGame");
+    updateGame(deltaTime);
 }
 
-void keyboard(unsigned char key, int x, int y) {
-    switch (key) {
-    case 27: // ESC key
-        exit(0);
-        break;
+// ===== Input and replays =====
+// Keys that change the simulation are queued and applied at the start of
+// the next tick, so --record/--replay reproduce a run exactly. The GLUT
+// callbacks pass them through keyPresses, which runTick() drains on
+// whichever thread runs the simulation.
 
+void applyInput(bool special, int key, bool pressed) {
+    if (special || !pressed) return;
+    switch (key) {
     case 'p':
     case 'P':
         gamePaused = !gamePaused;
         break;
 
     case ' ':
-        if (!gameOver && !gamePaused) {
-            shipVelocity = 0.08f;
-        }
+        boost();
         break;
 
     default:
         if (gameOver) {
-            // Restart game
-            shipY = 0.0f;
-            shipVelocity = 0.0f;
-            pipes.clear();
-            pipes.push_back({ 20.0f, 0.0f });
-            gameOver = false;
-            score = 0;
+            restartGame();
         }
         break;
     }
 }
 
+void hashState(StateHash& hash) {
+    hash.add(shipY);
+    hash.add(shipVelocity);
+    hash.add(gameOver);
+    hash.add(gamePaused);
+    hash.add(score);
+    hash.add(nextPipe);
+    for (size_t i = 0; i < pipes.size(); i++) {
+        hash.add(pipes[i].x);
+        hash.add(pipes[i].gapY);
+    }
+}
+
+InputReplay inputReplay(applyInput, hashState);
+const char* replayPath = nullptr; // --replay FILE
+
+ReplayHeader replayHeader() {
+    ReplayHeader header;
+    header.game = GAME_TITLE;
+    header.seed = gameSeed;
+    header.settings = { floatBits(pipeSpeed), floatBits(pipeSpacing) };
+    return header;
+}
+
+// --record FILE or --replay FILE; false if the replay can't be loaded
+bool startReplay(const char* recordPath, const char* playPath) {
+    if (playPath) {
+        ReplayHeader header;
+        if (!inputReplay.startPlayback(playPath, GAME_TITLE, header) || header.settings.size() != 2) return false;
+        replayPath = playPath;
+        gameSeed = header.seed;
+        pipeSpeed = bitsFloat(header.settings[0]);
+        pipeSpacing = bitsFloat(header.settings[1]);
+    }
+    else if (recordPath && inputReplay.startRecording(recordPath, replayHeader())) {
+        atexit([] { inputReplay.stopRecording(); });
+    }
+    return true;
+}
+
+// One fixed tick with its input; the only way the simulation advances
+void runTick(float deltaTime) {
+    KeyInput press;
+    while (keyPresses.pop(press)) inputReplay.queue(press.special, press.key);
+    if (inputReplay.finished()) {
+        inputReplay.reportPlayback(replayPath);
+        inputReplay.stopPlayback();
+    }
+    inputReplay.beginTick();
+    stepGame(deltaTime);
+    inputReplay.endTick();
+}
+
+// ===== Simulation thread =====
+
+// Nonzero while nothing on screen can move. Only pausing stops the stars;
+// after a crash they keep drifting past the game-over text.
+uint32_t stillFrameId() {
+    if (!cacheStillFrames || !gamePaused) return 0;
+    StateHash hash;
+    hash.add(starfield.ticks());
+    hash.add(shipY);
+    hash.add(score);
+    hash.add(highScore);
+    hash.add(gameOver);
+    return (uint32_t)hash.value() | 1;
+}
+
+// Copies what render() reads into the next snapshot and hands it over
+void publishSnapshot() {
+    SceneSnapshot& snapshot = snapshots.back();
+    snapshot.time = simulation.tickTime();
+    snapshot.shipY = shipY;
+    snapshot.prevShipY = prevShipY;
+    snapshot.pipes = pipes;
+    snapshot.starTicks = starfield.ticks();
+    snapshot.score = score;
+    snapshot.highScore = highScore;
+    snapshot.gameOver = gameOver;
+    snapshot.gamePaused = gamePaused;
+    snapshot.stillFrame = stillFrameId();
+    snapshots.publish();
+    latestStillFrame.store(snapshot.stillFrame, std::memory_order_release);
+}
+
+void stopSimulation() {
+    simulation.stop();
+}
+
+// Moves the ticks off the GLUT thread. The thread is stopped at exit before
+// anything it touches is destroyed.
+void startSimulation() {
+    static bool stopAtExit = false;
+    if (!stopAtExit) {
+        atexit(stopSimulation);
+        stopAtExit = true;
+    }
+    simulation.start(frameClock.dt(), runTick, publishSnapshot);
+}
+
+void animate(int value) {
+    profiler().beginFrame();
+    int ticks = frameClock.beginFrame();
+    if (!simulation.running()) {
+        ProfileZone zone("update");
+        for (int i = 0; i < ticks; i++) {
+            runTick(frameClock.dt());
+        }
+        if (ticks > 0) publishSnapshot();
+    }
+    if (needsRedraw()) glutPostRedisplay();
+    glutTimerFunc(frameClock.nextFrameDelayMs(), animate, 0);
+}
+
+void specialKeys(int key, int x, int y) {
+    if (key == GLUT_KEY_F3) profiler().toggleOverlay();
+}
+
+void keyboard(unsigned char key, int x, int y) {
+    if (key == 27) exit(0); // ESC key
+    keyPresses.push({ false, key });
+}
+
 void setupLighting() {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_LIGHTING);
@@ -356,24 +597,543 @@ void setupLighting() {
     glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
     glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
     glLightfv(GL_LIGHT0, GL_SPECULAR, lightSpecular);
+
+    // Without GL_COLOR_MATERIAL this one material shades every lit object
+    GLfloat ambient[] = { 0.3f, 0.25f, 0.25f, 1.0f };
+    GLfloat diffuse[] = { 0.7f, 0.6f, 0.5f, 1.0f };
+    GLfloat specular[] = { 0.4f, 0.4f, 0.4f, 1.0f };
+    GLfloat shininess = 30.0f;
+    glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
+    glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
+    glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
+    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
 }
 
+// ===== Headless simulation =====
+// --headless --ticks N [--seed S] [--input autopilot|random]
+// Runs updateGame() as fast as possible without GLUT or a window, restarting
+// after every crash, and reports simulation throughput.
+
+// Boosts when the ship is heading below the next pipe's gap
+bool autopilotBoost() {
+    for (size_t i = nextPipe; i < pipes.size(); i++) {
+        const Pipe& pipe = pipes[i];
+        if (pipe.x > shipX - 1.0f) {
+            return shipY + shipVelocity / 6.0f < pipe.gapY - 1.0f;
+        }
+    }
+    return shipY < 0.0f && shipVelocity <= 0.0f;
+}
+
+// Queues one tick of scripted play: a restart after a crash, then a boost
+// when the autopilot (or a random press) calls for one
+void scriptedInput(bool randomInput) {
+    if (gameOver) inputReplay.queue(false, '\r'); // any key restarts
+    bool press = randomInput ? inputRng.range(30) == 0 : autopilotBoost();
+    if (press) inputReplay.queue(false, ' ');
+}
+
+int runHeadless(long ticks, bool randomInput) {
+    persistHighScore = false;
+    profiler().enabled = profiler().isTracing();
+    initializeStars();
+
+    size_t peakPipes = pipes.size();
+    int gamesPlayed = 1;
+    int bestScore = 0;
+
+    // A replay runs to its end, with all input coming from the file
+    bool replaying = inputReplay.playing();
+    auto start = std::chrono::steady_clock::now();
+    long tick = 0;
+    for (; replaying ? !inputReplay.finished() : tick < ticks; tick++) {
+        if (!replaying) scriptedInput(randomInput);
+
+        bool wasOver = gameOver;
+        runTick(frameClock.dt());
+        if (wasOver && !gameOver) gamesPlayed++;
+        bestScore = std::max(bestScore, score);
+        peakPipes = std::max(peakPipes, pipes.size());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("Flappy Spaceship headless: %ld ticks, seed %llu, %s input\n", tick, (unsigned long long)gameSeed,
+        replaying ? "replayed" : randomInput ? "random" : "autopilot");
+    printf("  ticks/second: %.0f\n", seconds > 0.0 ? tick / seconds : 0.0);
+    printf("  peak pipes: %zu\n", peakPipes);
+    printf("  games played: %d, best score: %d, final score: %d\n", gamesPlayed, bestScore, score);
+    if (replaying && !inputReplay.reportPlayback(replayPath)) return 1;
+    return 0;
+}
+
+// ===== Batched simulation =====
+// --batch N --ticks T [--seed S] [--policy autopilot|random] [--threads N]
+// Plays N independent games in lock-step for tuning the course, restarting
+// each one after every crash, and reports games/second and the score
+// distribution. Game g plays seed S + g exactly as a headless run with that
+// seed would: the rules are updateGame()'s, step by step.
+//
+// Each game is a lane in structure-of-arrays columns, and every per-tick
+// pass runs over groups of LANE_GROUP lanes, so the ship physics, the
+// pipe movement and the gap checks compile to SIMD compares and selects.
+// A lane's pipes all move the same step each tick, so a pipe's x is a
+// function of its age alone; only the three pipes the rules look at (the
+// oldest, the one at the ship and the newest) keep a live x column, and the
+// rest are stored as gap height and spawn tick. Spawning, moving the cursor
+// on and despawning are rare per lane, so those run as scalar passes.
+
+class FlappyBatch {
+public:
+    static const size_t LANE_GROUP = 8;    // lanes per SIMD group; padding lanes fill out the last one
+    static const size_t BLOCK_GROUPS = 32; // 256 lanes run through every tick at a time, while in L1
+
+    // Decides this tick's boosts for lanes [begin, end): sets boost[i] to 0 or 1
+    typedef void (*Policy)(FlappyBatch& batch, size_t begin, size_t end);
+
+    // The course being tuned; the game's own globals are left alone
+    struct Rules {
+        float gravity, boostVelocity, gapSize;
+        float pipeSpeed, pipeSpacing;
+    };
+
+    // One column per field, indexed by lane; policies read the ship and the
+    // pipe at the ship
+    std::vector<float> shipY, shipVelocity;
+    std::vector<float> nextX, nextGapY;  // the pipe at the ship, while hasNext
+    std::vector<uint32_t> hasNext;
+    std::vector<uint32_t> boost;         // written by the policy each tick
+    std::vector<uint32_t> crashed;       // game over; the lane restarts next tick
+    std::vector<int> score;
+    std::vector<RandomStream> inputRngs; // each lane's scripted-input stream
+
+    // Finished games by score, from the requested lanes only
+    std::vector<uint64_t> scoreCounts;
+    uint64_t gamesFinished = 0;
+
+    size_t lanes() const {
+        return shipY.size();
+    }
+
+    // The games asked for; lanes past these are padding
+    size_t games() const {
+        return gameCount;
+    }
+
+    // Starts `games` fresh games. The lanes are padded to whole groups; the
+    // padding plays along but its games are never counted.
+    void reset(size_t games, uint64_t seed, const Rules& courseRules) {
+        rules = courseRules;
+        gameCount = games;
+        size_t count = (games + LANE_GROUP - 1) / LANE_GROUP * LANE_GROUP;
+        step = rules.pipeSpeed * frameClock.dt();
+        spawnThreshold = PIPE_SPAWN_X - rules.pipeSpacing;
+        gapHalf = rules.gapSize / 2.0f;
+
+        // A lane holds at most one pipe per spacing along the course, plus
+        // the one just spawned and the one about to leave
+        ringSize = 1;
+        while (ringSize < (size_t)((PIPE_SPAWN_X - PIPE_DESPAWN_X) / rules.pipeSpacing) + 2) ringSize *= 2;
+
+        // x after each number of moves, up to the first past the despawn line
+        pipeXAtAge.assign(1, PIPE_SPAWN_X);
+        while (pipeXAtAge.back() >= PIPE_DESPAWN_X) pipeXAtAge.push_back(pipeXAtAge.back() - step);
+
+        shipY.assign(count, 0.0f);
+        shipVelocity.assign(count, 0.0f);
+        nextX.assign(count, 0.0f);
+        nextGapY.assign(count, 0.0f);
+        frontX.assign(count, 0.0f);
+        lastX.assign(count, 0.0f);
+        hasNext.assign(count, 0);
+        boost.assign(count, 0);
+        crashed.assign(count, 0);
+        score.assign(count, 0);
+        ringHead.assign(count, 0);
+        ringCount.assign(count, 0);
+        nextIndex.assign(count, 0);
+        ringGapY.assign(count * ringSize, 0.0f);
+        ringSpawnTick.assign(count * ringSize, 0);
+        pipeRngs.resize(count);
+        inputRngs.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            pipeRngs[i].seed(seed + i, 1);
+            inputRngs[i].seed(seed + i, 2);
+            restartLane(i, 0);
+        }
+        scoreCounts.clear();
+        gamesFinished = 0;
+        tick = 0;
+    }
+
+    // Advances every lane `ticks` ticks. Blocks of lanes run on the job
+    // system, each through all the ticks before the next; lanes never
+    // interact, so the results are the same for every thread count.
+    void run(long ticks, Policy policy) {
+        std::mutex statsLock;
+        size_t groups = lanes() / LANE_GROUP;
+        jobSystem().parallelFor(0, groups, BLOCK_GROUPS, [&](size_t first, size_t last) {
+            std::vector<uint64_t> counts;
+            for (size_t group = first; group < last; group += BLOCK_GROUPS) {
+                size_t begin = group * LANE_GROUP;
+                size_t end = std::min(last, group + BLOCK_GROUPS) * LANE_GROUP;
+                for (long t = 0; t < ticks; t++) {
+                    stepLanes(begin, end, (uint32_t)(tick + t), policy, counts);
+                }
+            }
+            std::lock_guard<std::mutex> lock(statsLock);
+            if (scoreCounts.size() < counts.size()) scoreCounts.resize(counts.size());
+            for (size_t s = 0; s < counts.size(); s++) {
+                scoreCounts[s] += counts[s];
+                gamesFinished += counts[s];
+            }
+        });
+        tick += ticks;
+    }
+
+private:
+    Rules rules;
+    size_t gameCount = 0;
+    float step = 0.0f;           // how far pipes move per tick
+    float spawnThreshold = 0.0f; // the newest pipe's x once the next may spawn
+    float gapHalf = 0.0f;
+    size_t ringSize = 1;         // power of two
+    long tick = 0;
+    std::vector<float> pipeXAtAge;
+
+    std::vector<float> frontX, lastX;     // the oldest and newest pipe
+    std::vector<uint32_t> ringHead, ringCount, nextIndex;
+    std::vector<float> ringGapY;          // lane i's pipes at [i * ringSize, (i + 1) * ringSize)
+    std::vector<uint32_t> ringSpawnTick;
+    std::vector<RandomStream> pipeRngs;
+
+    size_t pipeSlot(size_t lane, uint32_t index) const {
+        return lane * ringSize + ((ringHead[lane] + index) & (ringSize - 1));
+    }
+
+    // x of pipe `slot` during the tick, once the pipes have moved
+    float pipeX(size_t slot, uint32_t now) const {
+        return pipeXAtAge[now + 1 - ringSpawnTick[slot]];
+    }
+
+    void stepLanes(size_t begin, size_t end, uint32_t now, Policy policy, std::vector<uint64_t>& counts) {
+        size_t groups = (end - begin) / LANE_GROUP;
+        policy(*this, begin, end);
+
+        for (size_t i = begin; i < end; i++) {
+            if (crashed[i]) {
+                if (i < gameCount) {
+                    if ((size_t)score[i] >= counts.size()) counts.resize(score[i] + 1);
+                    counts[score[i]]++;
+                }
+                restartLane(i, now);
+            }
+            if (ringCount[i] == 0 || lastX[i] < spawnThreshold) spawnPipe(i, now);
+        }
+
+        flyLanes(groups, &shipY[begin], &shipVelocity[begin], &boost[begin], &nextX[begin], &frontX[begin],
+            &lastX[begin], rules.boostVelocity, rules.gravity * frameClock.dt(), frameClock.dt(), step);
+
+        for (size_t i = begin; i < end; i++) {
+            while (hasNext[i] && nextX[i] <= -6.0f) advanceCursor(i, now);
+            while (ringCount[i] > 0 && frontX[i] < PIPE_DESPAWN_X) despawnPipe(i, now);
+        }
+
+        crashLanes(groups, &shipY[begin], &nextX[begin], &nextGapY[begin], &hasNext[begin], &crashed[begin], gapHalf);
+    }
+
+    // restartGame() for one lane
+    void restartLane(size_t i, uint32_t now) {
+        shipY[i] = 0.0f;
+        shipVelocity[i] = 0.0f;
+        ringHead[i] = 0;
+        ringCount[i] = 1;
+        ringGapY[i * ringSize] = 0.0f;
+        ringSpawnTick[i * ringSize] = now;
+        frontX[i] = nextX[i] = lastX[i] = PIPE_SPAWN_X;
+        nextGapY[i] = 0.0f;
+        hasNext[i] = 1;
+        nextIndex[i] = 0;
+        score[i] = 0;
+        crashed[i] = 0;
+    }
+
+    void spawnPipe(size_t i, uint32_t now) {
+        float gapY = (pipeRngs[i].range(150) - 75) / 10.0f;
+        size_t slot = pipeSlot(i, ringCount[i]);
+        ringGapY[slot] = gapY;
+        ringSpawnTick[slot] = now;
+        if (ringCount[i] == 0) frontX[i] = PIPE_SPAWN_X;
+        if (!hasNext[i]) {
+            nextX[i] = PIPE_SPAWN_X;
+            nextGapY[i] = gapY;
+            hasNext[i] = 1;
+        }
+        lastX[i] = PIPE_SPAWN_X;
+        ringCount[i]++;
+    }
+
+    // The pipe at the ship has cleared it; the one behind takes over
+    void advanceCursor(size_t i, uint32_t now) {
+        nextIndex[i]++;
+        if (nextIndex[i] == ringCount[i]) {
+            hasNext[i] = 0;
+            return;
+        }
+        size_t slot = pipeSlot(i, nextIndex[i]);
+        nextX[i] = pipeX(slot, now);
+        nextGapY[i] = ringGapY[slot];
+    }
+
+    void despawnPipe(size_t i, uint32_t now) {
+        ringHead[i] = (ringHead[i] + 1) & (ringSize - 1);
+        ringCount[i]--;
+        if (nextIndex[i] > 0) nextIndex[i]--;
+        score[i]++;
+        if (ringCount[i] > 0) frontX[i] = pipeX(pipeSlot(i, 0), now);
+    }
+
+    // Ship physics and pipe movement; the inner loops have a fixed trip
+    // count so they vectorise without a scalar remainder
+    static void flyLanes(size_t groups, float* __restrict y, float* __restrict velocity, const uint32_t* __restrict boosts,
+        float* __restrict next, float* __restrict front, float* __restrict last,
+        float boostVelocity, float gravityStep, float dt, float pipeStep) {
+        for (size_t group = 0; group < groups; group++) {
+            for (size_t k = 0; k < LANE_GROUP; k++) {
+                size_t i = group * LANE_GROUP + k;
+                float v = boosts[i] ? boostVelocity : velocity[i];
+                v += gravityStep;
+                velocity[i] = v;
+                y[i] += v * dt;
+                next[i] -= pipeStep;
+                front[i] -= pipeStep;
+                last[i] -= pipeStep;
+            }
+        }
+    }
+
+    static void crashLanes(size_t groups, const float* __restrict y, const float* __restrict next,
+        const float* __restrict gapY, const uint32_t* __restrict hasPipe, uint32_t* __restrict crash, float gapHalf) {
+        for (size_t group = 0; group < groups; group++) {
+            for (size_t k = 0; k < LANE_GROUP; k++) {
+                size_t i = group * LANE_GROUP + k;
+                uint32_t inPipe = hasPipe[i] & (next[i] < -5.5f);
+                uint32_t outsideGap = (y[i] < gapY[i] - gapHalf) | (y[i] > gapY[i] + gapHalf);
+                crash[i] = (inPipe & outsideGap) | (y[i] < -10.0f) | (y[i] > 10.0f);
+            }
+        }
+    }
+};
+
+// autopilotBoost() for a group of lanes, as selects
+void autopilotLanes(size_t groups, const float* __restrict y, const float* __restrict velocity,
+    const float* __restrict gapY, const uint32_t* __restrict hasPipe, uint32_t* __restrict boost) {
+    for (size_t group = 0; group < groups; group++) {
+        for (size_t k = 0; k < FlappyBatch::LANE_GROUP; k++) {
+            size_t i = group * FlappyBatch::LANE_GROUP + k;
+            uint32_t belowGap = y[i] + velocity[i] / 6.0f < gapY[i] - 1.0f;
+            uint32_t sinking = (y[i] < 0.0f) & (velocity[i] <= 0.0f);
+            boost[i] = (hasPipe[i] & belowGap) | (~hasPipe[i] & sinking);
+        }
+    }
+}
+
+void autopilotPolicy(FlappyBatch& batch, size_t begin, size_t end) {
+    autopilotLanes((end - begin) / FlappyBatch::LANE_GROUP, &batch.shipY[begin], &batch.shipVelocity[begin],
+        &batch.nextGapY[begin], &batch.hasNext[begin], &batch.boost[begin]);
+}
+
+// scriptedInput(true): a press on about one tick in 30
+void randomPolicy(FlappyBatch& batch, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        batch.boost[i] = batch.inputRngs[i].range(30) == 0;
+    }
+}
+
+struct BatchPolicy {
+    const char* name;
+    FlappyBatch::Policy decide;
+};
+const BatchPolicy BATCH_POLICIES[] = {
+    { "autopilot", autopilotPolicy },
+    { "random", randomPolicy },
+};
+
+// The score `fraction` of the way up the finished games
+int scorePercentile(const std::vector<uint64_t>& counts, uint64_t total, double fraction) {
+    uint64_t seen = 0;
+    for (size_t s = 0; s < counts.size(); s++) {
+        seen += counts[s];
+        if (seen > fraction * total) return (int)s;
+    }
+    return counts.empty() ? 0 : (int)counts.size() - 1;
+}
+
+int runBatch(long games, long ticks, const char* policyName, const FlappyBatch::Rules& rules) {
+    const BatchPolicy* policy = nullptr;
+    for (const BatchPolicy& candidate : BATCH_POLICIES) {
+        if (strcmp(candidate.name, policyName) == 0) policy = &candidate;
+    }
+    if (!policy || games <= 0 || rules.pipeSpeed <= 0.0f) {
+        fprintf(stderr, "--batch needs a game count, a positive --pipe-speed and --policy autopilot or random\n");
+        return 1;
+    }
+
+    static FlappyBatch batch; // large; kept off the stack
+    batch.reset((size_t)games, gameSeed, rules);
+    auto start = std::chrono::steady_clock::now();
+    batch.run(ticks, policy->decide);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t finished = batch.gamesFinished;
+    double total = 0.0;
+    for (size_t s = 0; s < batch.scoreCounts.size(); s++) total += (double)s * batch.scoreCounts[s];
+    printf("Flappy Spaceship batch: %zu games, %ld ticks, seed %llu, %s policy, %d threads\n", batch.games(), ticks,
+        (unsigned long long)gameSeed, policy->name, jobSystem().threadCount());
+    printf("  gravity %g, boost %g, gap %g, pipe speed %g, spacing %g\n", rules.gravity, rules.boostVelocity,
+        rules.gapSize, rules.pipeSpeed, rules.pipeSpacing);
+    printf("  game ticks/second: %.0f\n", seconds > 0.0 ? batch.games() * (double)ticks / seconds : 0.0);
+    printf("  games finished: %llu, games/second: %.0f\n", (unsigned long long)finished,
+        seconds > 0.0 ? finished / seconds : 0.0);
+    if (finished > 0) {
+        printf("  scores: mean %.2f, p50 %d, p90 %d, p99 %d, max %d\n", total / finished,
+            scorePercentile(batch.scoreCounts, finished, 0.5), scorePercentile(batch.scoreCounts, finished, 0.9),
+            scorePercentile(batch.scoreCounts, finished, 0.99), (int)batch.scoreCounts.size() - 1);
+    }
+    return 0;
+}
+
+// ===== Arcade host interface =====
+
+class FlappyGame : public ArcadeGame {
+public:
+    const char* title() const override {
+        return GAME_TITLE;
+    }
+
+    void init(uint64_t seed) override {
+        gameSeed = seed;
+        setupLighting();
+        initMeshes();
+        initTextOverlay();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        initializeStars();
+        frameCache.clear();
+        restartGame();
+        gamePaused = false;
+        publishSnapshot();
+    }
+
+    void update(float deltaTime) override {
+        runTick(deltaTime);
+        publishSnapshot();
+    }
+
+    void startSimulationThread() override {
+        startSimulation();
+    }
+
+    void render(float alpha, float time) override {
+        flappy::render(alpha, time);
+    }
+
+    void framePresented() override {
+    }
+
+    bool needsRedraw() override {
+        return flappy::needsRedraw();
+    }
+
+    void reshape(int width, int height) override {
+        flappy::reshape(width, height);
+    }
+
+    void keyDown(unsigned char key) override {
+        keyboard(key, 0, 0);
+    }
+
+    void specialKeyDown(int key) override {
+        specialKeys(key, 0, 0);
+    }
+
+    // Every Flappy input acts on the press
+    void keyUp(unsigned char key) override {
+    }
+
+    void specialKeyUp(int key) override {
+    }
+
+    void shutdown() override {
+        stopSimulation();
+        recordScore(); // a game left mid-run still counts
+    }
+};
+
+inline ArcadeGame& game() {
+    static FlappyGame instance;
+    return instance;
+}
+
+} // namespace flappy
+
+#ifndef SPACESHIP_ARCADE_HOST
 int main(int argc, char** argv) {
+    using namespace flappy;
+
+    gameSeed = argUint64(argc, argv, "--seed", gameSeed);
+    if (const char* tracePath = argValue(argc, argv, "--trace")) startProfilerTrace(tracePath);
+    pipeSpeed = (float)atof(argValue(argc, argv, "--pipe-speed", "6"));
+    pipeSpacing = std::max(MIN_PIPE_SPACING, (float)atof(argValue(argc, argv, "--pipe-spacing", "10")));
+    if (!startReplay(argValue(argc, argv, "--record"), argValue(argc, argv, "--replay"))) return 1;
+
+    // --pipes N spaces the course so about N pipes are on screen
+    if (hasArg(argc, argv, "--benchmark")) {
+        persistHighScore = false;
+        cacheStillFrames = false;
+        long pipeCount = argLong(argc, argv, "--pipes", 0);
+        if (pipeCount > 0) pipeSpacing = std::max(MIN_PIPE_SPACING, (PIPE_SPAWN_X - PIPE_DESPAWN_X) / pipeCount);
+        return runRenderBenchmark(argc, argv, game(), [] { scriptedInput(false); });
+    }
+
+    if (hasArg(argc, argv, "--batch")) {
+        jobSystem().setThreadCount(argLong(argc, argv, "--threads", jobSystem().threadCount()));
+        FlappyBatch::Rules rules;
+        rules.gravity = (float)atof(argValue(argc, argv, "--gravity", "-18"));
+        rules.boostVelocity = (float)atof(argValue(argc, argv, "--boost", "4.8"));
+        rules.gapSize = (float)atof(argValue(argc, argv, "--gap-size", "6"));
+        rules.pipeSpeed = pipeSpeed;
+        rules.pipeSpacing = pipeSpacing;
+        return runBatch(argLong(argc, argv, "--batch", 4096), argLong(argc, argv, "--ticks", 100000),
+            argValue(argc, argv, "--policy", "autopilot"), rules);
+    }
+
+    if (hasArg(argc, argv, "--headless")) {
+        const char* input = argValue(argc, argv, "--input", "autopilot");
+        return runHeadless(argLong(argc, argv, "--ticks", 100000), strcmp(input, "random") == 0);
+    }
+
+    frameClock.setTargetFps(argLong(argc, argv, "--fps", 60));
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
-    glutCreateWindow("Flappy Spaceship");
+    glutCreateWindow(GAME_TITLE);
 
     initializeStars();
     setupLighting();
+    initMeshes();
+    initTextOverlay();
+    publishSnapshot();
+    if (!hasArg(argc, argv, "--no-sim-thread")) startSimulation();
 
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);
+    glutSpecialFunc(specialKeys);
     glutTimerFunc(0, animate, 0);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
     glutMainLoop();
     return 0;
-
 }
+#endif
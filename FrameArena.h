@@ -0,0 +1,61 @@
+#pragma once
+
+// Per-frame scratch memory.
+// Lists a frame builds and throws away (which enemies are visible, in what
+// order) are carved out of one preallocated block by bumping an offset, and
+// reset() at the start of the next frame frees them all at once. Only
+// trivially destructible types go in, since nothing is ever destroyed.
+//
+// A frame that needs more than the block holds takes the rest from the
+// heap. reset() then grows the block to that frame's high-water mark, so
+// only the first frames of a bigger scene allocate.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity) : block(new unsigned char[capacity]), capacity(capacity) {
+    }
+
+    // Room for `count` T, uninitialised, valid until the next reset()
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+        size_t bytes = count * sizeof(T);
+        size_t start = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        used = start + bytes;
+        peak = std::max(peak, used);
+        if (used <= capacity) return reinterpret_cast<T*>(block.get() + start);
+
+        overflow.emplace_back(new unsigned char[bytes ? bytes : 1]);
+        return reinterpret_cast<T*>(overflow.back().get());
+    }
+
+    // Start of a frame: everything allocated before is gone
+    void reset() {
+        if (peak > capacity) {
+            capacity = peak + peak / 2;
+            block.reset(new unsigned char[capacity]);
+        }
+        overflow.clear();
+        used = peak = 0;
+    }
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity;
+    size_t used = 0;
+    size_t peak = 0; // this frame's total, including what overflowed
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+};
+
+// The render thread's arena, reset at the start of each frame that uses it
+inline FrameArena& frameArena() {
+    static FrameArena arena(256 * 1024);
+    return arena;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Idle rendering.
+// A paused or finished game shows the same frame until something happens.
+// Its host keeps a copy of that frame in a texture, tagged with an id for
+// the still state it shows, and stops redrawing while the game stays in
+// that state. A redraw GLUT asks for anyway, when the window is uncovered,
+// just blits the copy instead of rendering the scene again.
+
+#include "GLExtensions.h"
+#include <cstdint>
+
+class FrameCache {
+public:
+    // Whether the copy shows still state `id` at this window size; 0 is
+    // never still
+    bool holds(uint32_t id, int width, int height) const {
+        return id != 0 && id == cachedId && width == cachedWidth && height == cachedHeight;
+    }
+
+    // Copies the frame just rendered from the back buffer, before the swap
+    void capture(uint32_t id, int width, int height) {
+        if (!texture) glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (width != cachedWidth || height != cachedHeight) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            cachedWidth = width;
+            cachedHeight = height;
+        }
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        cachedId = id;
+    }
+
+    // Covers the window with the copy, pixel for pixel
+    void draw() const {
+        glPushAttrib(GL_ALL_ATTRIB_BITS);
+        glViewport(0, 0, cachedWidth, cachedHeight);
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_BLEND);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, -1.0f);
+        glTexCoord2f(1.0f, 0.0f); glVertex2f(1.0f, -1.0f);
+        glTexCoord2f(1.0f, 1.0f); glVertex2f(1.0f, 1.0f);
+        glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, 1.0f);
+        glEnd();
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
+        glPopAttrib();
+    }
+
+    // Forgets the copy, e.g. when the GL context it lives in goes away
+    void clear() {
+        cachedId = 0;
+    }
+
+private:
+    GLuint texture = 0;
+    uint32_t cachedId = 0;
+    int cachedWidth = 0, cachedHeight = 0;
+};
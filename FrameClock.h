@@ -0,0 +1,101 @@
+#pragma once
+
+// Fixed-timestep frame clock.
+// Real time is measured once per frame and fed into an accumulator that is
+// drained in fixed simulation ticks, so game speed no longer depends on how
+// long a frame took. The leftover fraction of a tick is exposed as alpha()
+// for interpolating rendered positions between the last two sim states, and
+// nextFrameDelayMs() paces the GLUT timer against absolute deadlines so a
+// 60/120/144 Hz target is hit on average despite millisecond timer
+// granularity.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+class FrameClock {
+public:
+    static const int MAX_TICKS_PER_FRAME = 8; // beyond this the sim drops time rather than spiral
+
+    explicit FrameClock(double tickRate = 60.0)
+        : tickSeconds(1.0 / tickRate) {
+    }
+
+    // 0 means uncapped: the next frame is scheduled immediately
+    void setTargetFps(double fps) {
+        framePeriod = fps > 0.0 ? 1.0 / fps : 0.0;
+    }
+
+    // Samples real time for this frame; returns how many ticks to simulate
+    int beginFrame() {
+        Clock::time_point now = Clock::now();
+        if (!started) {
+            started = true;
+            startTime = lastFrame = nextDeadline = now;
+        }
+        frameSeconds = std::chrono::duration<double>(now - lastFrame).count();
+        lastFrame = now;
+        elapsed = std::chrono::duration<double>(now - startTime).count();
+
+        accumulator += frameSeconds;
+        int ticks = (int)(accumulator / tickSeconds);
+        if (ticks > MAX_TICKS_PER_FRAME) {
+            ticks = MAX_TICKS_PER_FRAME;
+            accumulator = 0.0;
+        }
+        else {
+            accumulator -= ticks * tickSeconds;
+        }
+        return ticks;
+    }
+
+    // Fixed simulation step in seconds
+    float dt() const {
+        return (float)tickSeconds;
+    }
+
+    // How far (0..1) real time has run past the last simulated tick
+    float alpha() const {
+        return (float)(accumulator / tickSeconds);
+    }
+
+    // Seconds since the first frame, sampled once per frame
+    float time() const {
+        return (float)elapsed;
+    }
+
+    // Real duration of the last frame in seconds
+    float frameTime() const {
+        return (float)frameSeconds;
+    }
+
+    // Delay for glutTimerFunc so frames land on the target rate
+    int nextFrameDelayMs() {
+        if (framePeriod <= 0.0) return 0;
+
+        Clock::time_point now = Clock::now();
+        nextDeadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(framePeriod));
+        if (nextDeadline < now) {
+            nextDeadline = now; // fell behind; don't try to catch up with a burst
+        }
+        double wait = std::chrono::duration<double, std::milli>(nextDeadline - now).count();
+        return (int)std::floor(wait + 0.5);
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    double tickSeconds;
+    double framePeriod = 1.0 / 60.0;
+    double accumulator = 0.0;
+    double frameSeconds = 0.0;
+    double elapsed = 0.0;
+    bool started = false;
+    Clock::time_point startTime;
+    Clock::time_point lastFrame;
+    Clock::time_point nextDeadline;
+};
+
+inline float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+// Runtime-loaded OpenGL entry points beyond 1.1.
+// Windows' opengl32 only exports GL 1.1, so everything newer is fetched
+// through the platform's GetProcAddress once a context is current.
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glut.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <GL/glx.h>
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_RENDERBUFFER 0x8D41
+#endif
+
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+#ifndef GL_POINT_SPRITE
+#define GL_POINT_SPRITE 0x8861
+#endif
+
+#ifndef GL_VERTEX_PROGRAM_POINT_SIZE
+#define GL_VERTEX_PROGRAM_POINT_SIZE 0x8642
+#endif
+
+struct GLExtensions {
+    typedef void (APIENTRY* GenBuffersProc)(GLsizei, GLuint*);
+    typedef void (APIENTRY* DeleteBuffersProc)(GLsizei, const GLuint*);
+    typedef void (APIENTRY* BindBufferProc)(GLenum, GLuint);
+    typedef void (APIENTRY* BufferDataProc)(GLenum, ptrdiff_t, const void*, GLenum);
+    typedef void (APIENTRY* BufferSubDataProc)(GLenum, ptrdiff_t, ptrdiff_t, const void*);
+
+    typedef GLuint (APIENTRY* CreateShaderProc)(GLenum);
+    typedef void (APIENTRY* DeleteShaderProc)(GLuint);
+    typedef void (APIENTRY* ShaderSourceProc)(GLuint, GLsizei, const char* const*, const GLint*);
+    typedef void (APIENTRY* CompileShaderProc)(GLuint);
+    typedef void (APIENTRY* GetShaderivProc)(GLuint, GLenum, GLint*);
+    typedef void (APIENTRY* GetShaderInfoLogProc)(GLuint, GLsizei, GLsizei*, char*);
+    typedef GLuint (APIENTRY* CreateProgramProc)();
+    typedef void (APIENTRY* AttachShaderProc)(GLuint, GLuint);
+    typedef void (APIENTRY* BindAttribLocationProc)(GLuint, GLuint, const char*);
+    typedef void (APIENTRY* LinkProgramProc)(GLuint);
+    typedef void (APIENTRY* GetProgramivProc)(GLuint, GLenum, GLint*);
+    typedef void (APIENTRY* GetProgramInfoLogProc)(GLuint, GLsizei, GLsizei*, char*);
+    typedef void (APIENTRY* UseProgramProc)(GLuint);
+    typedef GLint (APIENTRY* GetUniformLocationProc)(GLuint, const char*);
+    typedef void (APIENTRY* Uniform1iProc)(GLint, GLint);
+    typedef void (APIENTRY* Uniform1fProc)(GLint, GLfloat);
+    typedef void (APIENTRY* Uniform2fProc)(GLint, GLfloat, GLfloat);
+    typedef void (APIENTRY* Uniform3fProc)(GLint, GLfloat, GLfloat, GLfloat);
+    typedef void (APIENTRY* Uniform4fvProc)(GLint, GLsizei, const GLfloat*);
+    typedef void (APIENTRY* EnableVertexAttribArrayProc)(GLuint);
+    typedef void (APIENTRY* DisableVertexAttribArrayProc)(GLuint);
+    typedef void (APIENTRY* VertexAttribPointerProc)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+
+    typedef void (APIENTRY* VertexAttribDivisorProc)(GLuint, GLuint);
+    typedef void (APIENTRY* DrawElementsInstancedProc)(GLenum, GLsizei, GLenum, const void*, GLsizei);
+
+    typedef void (APIENTRY* GenFramebuffersProc)(GLsizei, GLuint*);
+    typedef void (APIENTRY* DeleteFramebuffersProc)(GLsizei, const GLuint*);
+    typedef void (APIENTRY* BindFramebufferProc)(GLenum, GLuint);
+    typedef void (APIENTRY* FramebufferTexture2DProc)(GLenum, GLenum, GLenum, GLuint, GLint);
+    typedef GLenum (APIENTRY* CheckFramebufferStatusProc)(GLenum);
+    typedef void (APIENTRY* GenRenderbuffersProc)(GLsizei, GLuint*);
+    typedef void (APIENTRY* DeleteRenderbuffersProc)(GLsizei, const GLuint*);
+    typedef void (APIENTRY* BindRenderbufferProc)(GLenum, GLuint);
+    typedef void (APIENTRY* RenderbufferStorageProc)(GLenum, GLenum, GLsizei, GLsizei);
+    typedef void (APIENTRY* FramebufferRenderbufferProc)(GLenum, GLenum, GLenum, GLuint);
+
+    typedef void (APIENTRY* GenQueriesProc)(GLsizei, GLuint*);
+    typedef void (APIENTRY* DeleteQueriesProc)(GLsizei, const GLuint*);
+    typedef void (APIENTRY* QueryCounterProc)(GLuint, GLenum);
+    typedef void (APIENTRY* GetQueryObjectivProc)(GLuint, GLenum, GLint*);
+    typedef void (APIENTRY* GetQueryObjectui64vProc)(GLuint, GLenum, uint64_t*);
+
+    bool loaded = false;
+    int majorVersion = 1;
+    int minorVersion = 1;
+
+    // Vertex buffer objects (GL 1.5 / ARB_vertex_buffer_object)
+    GenBuffersProc GenBuffers = nullptr;
+    DeleteBuffersProc DeleteBuffers = nullptr;
+    BindBufferProc BindBuffer = nullptr;
+    BufferDataProc BufferData = nullptr;
+    BufferSubDataProc BufferSubData = nullptr;
+
+    // GLSL programs (GL 2.0)
+    CreateShaderProc CreateShader = nullptr;
+    DeleteShaderProc DeleteShader = nullptr;
+    ShaderSourceProc ShaderSource = nullptr;
+    CompileShaderProc CompileShader = nullptr;
+    GetShaderivProc GetShaderiv = nullptr;
+    GetShaderInfoLogProc GetShaderInfoLog = nullptr;
+    CreateProgramProc CreateProgram = nullptr;
+    AttachShaderProc AttachShader = nullptr;
+    BindAttribLocationProc BindAttribLocation = nullptr;
+    LinkProgramProc LinkProgram = nullptr;
+    GetProgramivProc GetProgramiv = nullptr;
+    GetProgramInfoLogProc GetProgramInfoLog = nullptr;
+    UseProgramProc UseProgram = nullptr;
+    GetUniformLocationProc GetUniformLocation = nullptr;
+    Uniform1iProc Uniform1i = nullptr;
+    Uniform1fProc Uniform1f = nullptr;
+    Uniform2fProc Uniform2f = nullptr;
+    Uniform3fProc Uniform3f = nullptr;
+    Uniform4fvProc Uniform4fv = nullptr;
+    EnableVertexAttribArrayProc EnableVertexAttribArray = nullptr;
+    DisableVertexAttribArrayProc DisableVertexAttribArray = nullptr;
+    VertexAttribPointerProc VertexAttribPointer = nullptr;
+
+    // Instanced arrays (GL 3.3 / ARB_instanced_arrays + ARB_draw_instanced)
+    VertexAttribDivisorProc VertexAttribDivisor = nullptr;
+    DrawElementsInstancedProc DrawElementsInstanced = nullptr;
+
+    // Framebuffer objects (GL 3.0 / ARB_framebuffer_object)
+    GenFramebuffersProc GenFramebuffers = nullptr;
+    DeleteFramebuffersProc DeleteFramebuffers = nullptr;
+    BindFramebufferProc BindFramebuffer = nullptr;
+    FramebufferTexture2DProc FramebufferTexture2D = nullptr;
+    CheckFramebufferStatusProc CheckFramebufferStatus = nullptr;
+    GenRenderbuffersProc GenRenderbuffers = nullptr;
+    DeleteRenderbuffersProc DeleteRenderbuffers = nullptr;
+    BindRenderbufferProc BindRenderbuffer = nullptr;
+    RenderbufferStorageProc RenderbufferStorage = nullptr;
+    FramebufferRenderbufferProc FramebufferRenderbuffer = nullptr;
+
+    // Timestamp queries (GL 3.3 / ARB_timer_query)
+    GenQueriesProc GenQueries = nullptr;
+    DeleteQueriesProc DeleteQueries = nullptr;
+    QueryCounterProc QueryCounter = nullptr;
+    GetQueryObjectivProc GetQueryObjectiv = nullptr;
+    GetQueryObjectui64vProc GetQueryObjectui64v = nullptr;
+
+    bool hasVersion(int major, int minor) const {
+        return majorVersion > major || (majorVersion == major && minorVersion >= minor);
+    }
+
+    bool hasVertexBuffers() const {
+        return GenBuffers && DeleteBuffers && BindBuffer && BufferData && BufferSubData;
+    }
+
+    bool hasShaders() const {
+        return CreateShader && LinkProgram && UseProgram && VertexAttribPointer;
+    }
+
+    bool hasInstancing() const {
+        return hasVertexBuffers() && hasShaders() && VertexAttribDivisor && DrawElementsInstanced;
+    }
+
+    bool hasFramebuffers() const {
+        return GenFramebuffers && DeleteFramebuffers && BindFramebuffer && FramebufferTexture2D && CheckFramebufferStatus;
+    }
+
+    bool hasRenderbuffers() const {
+        return hasFramebuffers() && GenRenderbuffers && DeleteRenderbuffers && BindRenderbuffer
+            && RenderbufferStorage && FramebufferRenderbuffer;
+    }
+
+    bool hasTimerQueries() const {
+        return GenQueries && DeleteQueries && QueryCounter && GetQueryObjectiv && GetQueryObjectui64v;
+    }
+};
+
+inline GLExtensions& glExtensions() {
+    static GLExtensions ext;
+    return ext;
+}
+
+inline void* getGLProcAddress(const char* name) {
+#ifdef _WIN32
+    void* proc = (void*)wglGetProcAddress(name);
+    // Some drivers return small sentinel values instead of NULL
+    if (proc == (void*)0 || proc == (void*)1 || proc == (void*)2 || proc == (void*)3 || proc == (void*)-1) {
+        return nullptr;
+    }
+    return proc;
+#else
+    return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+}
+
+// Tries the core name first, then the ARB-suffixed one.
+template <typename Proc>
+void loadGLProc(Proc& proc, const char* name) {
+    proc = (Proc)getGLProcAddress(name);
+    if (!proc) {
+        char arbName[64];
+        size_t len = strlen(name);
+        if (len + 4 < sizeof(arbName)) {
+            memcpy(arbName, name, len);
+            memcpy(arbName + len, "ARB", 4);
+            proc = (Proc)getGLProcAddress(arbName);
+        }
+    }
+}
+
+inline bool hasGLExtension(const char* name) {
+    const char* all = (const char*)glGetString(GL_EXTENSIONS);
+    if (!all) return false;
+    size_t len = strlen(name);
+    for (const char* p = strstr(all, name); p; p = strstr(p + len, name)) {
+        bool startOk = (p == all || p[-1] == ' ');
+        bool endOk = (p[len] == ' ' || p[len] == '\0');
+        if (startOk && endOk) return true;
+    }
+    return false;
+}
+
+// Needs a current context; safe to call more than once.
+// GLX hands out dispatch stubs for any name, so every group is gated on
+// the context's version or extension string, not just on non-null pointers.
+inline GLExtensions& loadGLExtensions() {
+    GLExtensions& ext = glExtensions();
+    if (ext.loaded) return ext;
+
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version) {
+        ext.majorVersion = atoi(version);
+        const char* dot = strchr(version, '.');
+        ext.minorVersion = dot ? atoi(dot + 1) : 0;
+    }
+
+    if (ext.hasVersion(1, 5) || hasGLExtension("GL_ARB_vertex_buffer_object")) {
+        loadGLProc(ext.GenBuffers, "glGenBuffers");
+        loadGLProc(ext.DeleteBuffers, "glDeleteBuffers");
+        loadGLProc(ext.BindBuffer, "glBindBuffer");
+        loadGLProc(ext.BufferData, "glBufferData");
+        loadGLProc(ext.BufferSubData, "glBufferSubData");
+    }
+
+    if (ext.hasVersion(2, 0)) {
+        loadGLProc(ext.CreateShader, "glCreateShader");
+        loadGLProc(ext.DeleteShader, "glDeleteShader");
+        loadGLProc(ext.ShaderSource, "glShaderSource");
+        loadGLProc(ext.CompileShader, "glCompileShader");
+        loadGLProc(ext.GetShaderiv, "glGetShaderiv");
+        loadGLProc(ext.GetShaderInfoLog, "glGetShaderInfoLog");
+        loadGLProc(ext.CreateProgram, "glCreateProgram");
+        loadGLProc(ext.AttachShader, "glAttachShader");
+        loadGLProc(ext.BindAttribLocation, "glBindAttribLocation");
+        loadGLProc(ext.LinkProgram, "glLinkProgram");
+        loadGLProc(ext.GetProgramiv, "glGetProgramiv");
+        loadGLProc(ext.GetProgramInfoLog, "glGetProgramInfoLog");
+        loadGLProc(ext.UseProgram, "glUseProgram");
+        loadGLProc(ext.GetUniformLocation, "glGetUniformLocation");
+        loadGLProc(ext.Uniform1i, "glUniform1i");
+        loadGLProc(ext.Uniform1f, "glUniform1f");
+        loadGLProc(ext.Uniform2f, "glUniform2f");
+        loadGLProc(ext.Uniform3f, "glUniform3f");
+        loadGLProc(ext.Uniform4fv, "glUniform4fv");
+        loadGLProc(ext.EnableVertexAttribArray, "glEnableVertexAttribArray");
+        loadGLProc(ext.DisableVertexAttribArray, "glDisableVertexAttribArray");
+        loadGLProc(ext.VertexAttribPointer, "glVertexAttribPointer");
+    }
+
+    bool instancedArrays = ext.hasVersion(3, 3) || hasGLExtension("GL_ARB_instanced_arrays");
+    bool drawInstanced = ext.hasVersion(3, 1) || hasGLExtension("GL_ARB_draw_instanced");
+    if (instancedArrays && drawInstanced) {
+        loadGLProc(ext.VertexAttribDivisor, "glVertexAttribDivisor");
+        loadGLProc(ext.DrawElementsInstanced, "glDrawElementsInstanced");
+    }
+
+    // ARB_framebuffer_object uses the unsuffixed core names
+    if (ext.hasVersion(3, 0) || hasGLExtension("GL_ARB_framebuffer_object")) {
+        loadGLProc(ext.GenFramebuffers, "glGenFramebuffers");
+        loadGLProc(ext.DeleteFramebuffers, "glDeleteFramebuffers");
+        loadGLProc(ext.BindFramebuffer, "glBindFramebuffer");
+        loadGLProc(ext.FramebufferTexture2D, "glFramebufferTexture2D");
+        loadGLProc(ext.CheckFramebufferStatus, "glCheckFramebufferStatus");
+        loadGLProc(ext.GenRenderbuffers, "glGenRenderbuffers");
+        loadGLProc(ext.DeleteRenderbuffers, "glDeleteRenderbuffers");
+        loadGLProc(ext.BindRenderbuffer, "glBindRenderbuffer");
+        loadGLProc(ext.RenderbufferStorage, "glRenderbufferStorage");
+        loadGLProc(ext.FramebufferRenderbuffer, "glFramebufferRenderbuffer");
+    }
+
+    // ARB_timer_query uses the unsuffixed core names
+    if (ext.hasVersion(3, 3) || hasGLExtension("GL_ARB_timer_query")) {
+        loadGLProc(ext.GenQueries, "glGenQueries");
+        loadGLProc(ext.DeleteQueries, "glDeleteQueries");
+        loadGLProc(ext.QueryCounter, "glQueryCounter");
+        loadGLProc(ext.GetQueryObjectiv, "glGetQueryObjectiv");
+        loadGLProc(ext.GetQueryObjectui64v, "glGetQueryObjectui64v");
+    }
+
+    ext.loaded = true;
+    return ext;
+}
+
+inline GLuint compileShaderStage(GLenum stage, const char* source) {
+    GLExtensions& ext = glExtensions();
+    GLuint shader = ext.CreateShader(stage);
+    ext.ShaderSource(shader, 1, &source, nullptr);
+    ext.CompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    ext.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024] = "";
+        ext.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        fprintf(stderr, "Shader compile failed: %s\n", log);
+        ext.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Compiles and links a vertex/fragment pair. Attribute names are bound to
+// locations 0..n-1 in order. Returns 0 (after logging why) on failure.
+inline GLuint compileProgram(const char* vertexSource, const char* fragmentSource,
+    const char* const* attributes, int attributeCount) {
+    GLExtensions& ext = loadGLExtensions();
+    if (!ext.hasShaders()) return 0;
+
+    GLuint vertexShader = compileShaderStage(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShaderStage(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vertexShader || !fragmentShader) return 0;
+
+    GLuint program = ext.CreateProgram();
+    ext.AttachShader(program, vertexShader);
+    ext.AttachShader(program, fragmentShader);
+    for (int i = 0; i < attributeCount; ++i) {
+        ext.BindAttribLocation(program, i, attributes[i]);
+    }
+    ext.LinkProgram(program);
+    ext.DeleteShader(vertexShader);
+    ext.DeleteShader(fragmentShader);
+
+    GLint ok = GL_FALSE;
+    ext.GetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024] = "";
+        ext.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        fprintf(stderr, "Shader link failed: %s\n", log);
+        return 0;
+    }
+    return program;
+}
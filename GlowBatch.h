@@ -0,0 +1,128 @@
+#pragma once
+
+// Camera-facing glow geometry batched into one draw.
+// Beams become flat quads turned toward the eye and glow spheres become
+// discs in the view plane; unlit, they cover the same pixels in the same
+// flat colour as the cylinders and spheres they stand in for. Vertices are
+// rebuilt every frame into one array, streamed in a single buffer and drawn
+// additively with the blend and lighting state set once for the batch.
+
+#include "GLExtensions.h"
+#include <cmath>
+#include <vector>
+
+class GlowBatch {
+public:
+    // Reads the camera from the current modelview matrix; call after the
+    // view is set up and before adding geometry
+    void begin() {
+        vertices.clear();
+        GLfloat m[16];
+        glGetFloatv(GL_MODELVIEW_MATRIX, m);
+        rightX = m[0]; rightY = m[4]; rightZ = m[8];
+        upX = m[1]; upY = m[5]; upZ = m[9];
+        eyeX = -(m[0] * m[12] + m[1] * m[13] + m[2] * m[14]);
+        eyeY = -(m[4] * m[12] + m[5] * m[13] + m[6] * m[14]);
+        eyeZ = -(m[8] * m[12] + m[9] * m[13] + m[10] * m[14]);
+    }
+
+    static const int DISC_SEGMENTS = 10;
+    static const int BEAM_VERTICES = 6;
+    static const int DISC_VERTICES = 3 * DISC_SEGMENTS;
+
+    size_t size() const {
+        return vertices.size() / FLOATS_PER_VERTEX;
+    }
+
+    // Room for `count` vertices, so frames up to that size never allocate
+    void reserve(size_t count) {
+        vertices.reserve(count * FLOATS_PER_VERTEX);
+    }
+
+    // Segment (x0,y0,z0)-(x1,y1,z1) of the given radius, widened toward the eye
+    void addBeam(float x0, float y0, float z0, float x1, float y1, float z1, float radius, const float color[4]) {
+        float dx = x1 - x0, dy = y1 - y0, dz = z1 - z0;
+        float ex = eyeX - x0, ey = eyeY - y0, ez = eyeZ - z0;
+        float sx = dy * ez - dz * ey;
+        float sy = dz * ex - dx * ez;
+        float sz = dx * ey - dy * ex;
+        float length = std::sqrt(sx * sx + sy * sy + sz * sz);
+        if (length <= 0.0f) return;
+        float scale = radius / length;
+        sx *= scale; sy *= scale; sz *= scale;
+
+        addVertex(x0 - sx, y0 - sy, z0 - sz, color);
+        addVertex(x0 + sx, y0 + sy, z0 + sz, color);
+        addVertex(x1 + sx, y1 + sy, z1 + sz, color);
+        addVertex(x0 - sx, y0 - sy, z0 - sz, color);
+        addVertex(x1 + sx, y1 + sy, z1 + sz, color);
+        addVertex(x1 - sx, y1 - sy, z1 - sz, color);
+    }
+
+    // Sphere silhouette: a disc facing the eye
+    void addDisc(float x, float y, float z, float radius, const float color[4]) {
+        static float ring[DISC_SEGMENTS + 1][2];
+        static bool ringReady = false;
+        if (!ringReady) {
+            ringReady = true;
+            for (int i = 0; i <= DISC_SEGMENTS; i++) {
+                float angle = 6.2831853f * i / DISC_SEGMENTS;
+                ring[i][0] = std::cos(angle);
+                ring[i][1] = std::sin(angle);
+            }
+        }
+
+        for (int i = 0; i < DISC_SEGMENTS; i++) {
+            float c0 = ring[i][0] * radius, s0 = ring[i][1] * radius;
+            float c1 = ring[i + 1][0] * radius, s1 = ring[i + 1][1] * radius;
+            addVertex(x, y, z, color);
+            addVertex(x + rightX * c0 + upX * s0, y + rightY * c0 + upY * s0, z + rightZ * c0 + upZ * s0, color);
+            addVertex(x + rightX * c1 + upX * s1, y + rightY * c1 + upY * s1, z + rightZ * c1 + upZ * s1, color);
+        }
+    }
+
+    void draw() {
+        if (vertices.empty()) return;
+
+        GLExtensions& ext = loadGLExtensions();
+        const float* base = vertices.data();
+        if (ext.hasVertexBuffers()) {
+            if (!buffer) ext.GenBuffers(1, &buffer);
+            ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+            // Re-specifying the store orphans last frame's copy instead of stalling on it
+            ext.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+            base = nullptr;
+        }
+
+        glDisable(GL_LIGHTING);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glDepthMask(GL_FALSE);
+
+        GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, base);
+        glColorPointer(4, GL_FLOAT, stride, base + 3);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)size());
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glEnable(GL_LIGHTING);
+        if (buffer) ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    static const int FLOATS_PER_VERTEX = 7; // x, y, z, r, g, b, a
+    std::vector<float> vertices; // capacity is kept across frames
+    GLuint buffer = 0;
+    float rightX = 1.0f, rightY = 0.0f, rightZ = 0.0f;
+    float upX = 0.0f, upY = 1.0f, upZ = 0.0f;
+    float eyeX = 0.0f, eyeY = 0.0f, eyeZ = 0.0f;
+
+    void addVertex(float x, float y, float z, const float color[4]) {
+        vertices.insert(vertices.end(), { x, y, z, color[0], color[1], color[2], color[3] });
+    }
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+// Input-to-present latency.
+// record() timestamps an input event as its GLUT callback hands it over and
+// numbers it. Whatever consumes input notes published() before taking it;
+// once a frame drawn from the resulting state has been swapped to the
+// screen, presented() with that number closes every event up to it. The
+// time from each event to the first frame showing it is kept for report().
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class InputLatency {
+public:
+    static const uint32_t WINDOW = 256; // events awaiting a frame; older ones go unmeasured
+
+    explicit InputLatency(const char* name) : name(name) {
+    }
+
+    // GLUT thread, after the event is in the queue or KeyState it goes through
+    void record() {
+        uint32_t serial = recorded + 1;
+        arrived[serial % WINDOW] = Clock::now();
+        recorded = serial;
+        latest.store(serial, std::memory_order_release);
+    }
+
+    // Any thread: the newest event handed over so far
+    uint32_t published() const {
+        return latest.load(std::memory_order_acquire);
+    }
+
+    // GLUT thread, when the swap of a frame showing events up to `serial` returns
+    void presented(uint32_t serial) {
+        if (serial <= shown) return;
+        Clock::time_point now = Clock::now();
+        uint32_t first = std::max(shown + 1, recorded >= WINDOW ? recorded - WINDOW + 1 : 1u);
+        for (uint32_t event = first; event <= serial; event++) {
+            millis.push_back((float)std::chrono::duration<double, std::milli>(now - arrived[event % WINDOW]).count());
+        }
+        shown = serial;
+    }
+
+    // Prints the latency percentiles, if any event was measured
+    void report() const {
+        if (millis.empty()) return;
+        std::vector<float> sorted = millis;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](double p) {
+            return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+        };
+        printf("Input to present, %s: %zu events, p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n", name,
+            sorted.size(), percentile(0.5), percentile(0.9), percentile(0.99), sorted.back());
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    const char* name;
+    Clock::time_point arrived[WINDOW];
+    uint32_t recorded = 0; // GLUT thread's copy of latest
+    uint32_t shown = 0;
+    std::atomic<uint32_t> latest{ 0 };
+    std::vector<float> millis;
+};
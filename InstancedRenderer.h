@@ -0,0 +1,207 @@
+#pragma once
+
+// Instanced drawing of many copies of a cached mesh.
+// Per-instance transforms and tints are gathered into one buffer per frame
+// and each mesh part is drawn for every instance in a single call. A small
+// GLSL 1.20 shader reproduces the fixed-function lighting the games set up
+// (GL_LIGHT0/1, GL_COLOR_MATERIAL or glMaterial) so instanced and
+// immediate-drawn objects shade alike. Without instancing support the batch
+// falls back to one matrix push/pop per instance.
+
+#include "MeshCache.h"
+#include <vector>
+
+struct InstanceData {
+    float x, y, z;
+    float angle;                    // degrees about +y, like glRotatef(angle, 0, 1, 0)
+    float scaleX, scaleY, scaleZ;
+    float tintR, tintG, tintB, tint; // rgb blended over the part colour by tint
+};
+
+// Placement of a mesh within one instance: scale first, then offset
+struct PartTransform {
+    float offsetX = 0.0f, offsetY = 0.0f, offsetZ = 0.0f;
+    float scaleX = 1.0f, scaleY = 1.0f, scaleZ = 1.0f;
+};
+
+struct InstancedShader {
+    enum Attribute { POSITION, NORMAL, INSTANCE_POSITION, INSTANCE_SCALE, INSTANCE_TINT };
+
+    bool initialized = false;
+    GLuint program = 0;
+    GLint partColor = -1;
+    GLint partOffset = -1;
+    GLint partScale = -1;
+    GLint lighting = -1;
+    GLint colorMaterial = -1;
+    GLint lightEnabled = -1;
+};
+
+inline InstancedShader& instancedShader() {
+    static InstancedShader shader;
+    if (shader.initialized) return shader;
+    shader.initialized = true;
+
+    if (!loadGLExtensions().hasInstancing()) return shader;
+
+    static const char* vertexSource =
+        "#version 120\n"
+        "attribute vec3 position;\n"
+        "attribute vec3 normal;\n"
+        "attribute vec4 instancePosition;\n" // xyz, w = yaw in degrees
+        "attribute vec3 instanceScale;\n"
+        "attribute vec4 instanceTint;\n"
+        "uniform vec4 partColor;\n"
+        "uniform vec3 partOffset;\n"
+        "uniform vec3 partScale;\n"
+        "uniform bool lighting;\n"
+        "uniform bool colorMaterial;\n"
+        "uniform vec2 lightEnabled;\n"
+        "vec3 yaw(vec3 v, float c, float s) { return vec3(c * v.x + s * v.z, v.y, -s * v.x + c * v.z); }\n"
+        "void main() {\n"
+        "    float angle = radians(instancePosition.w);\n"
+        "    float c = cos(angle), s = sin(angle);\n"
+        "    vec3 p = yaw((position * partScale + partOffset) * instanceScale, c, s) + instancePosition.xyz;\n"
+        // Inverse-transpose of the scales, left unnormalised like fixed function without GL_NORMALIZE
+        "    vec3 n = yaw(normal / (partScale * instanceScale), c, s);\n"
+        "    vec4 eye = gl_ModelViewMatrix * vec4(p, 1.0);\n"
+        "    gl_Position = gl_ProjectionMatrix * eye;\n"
+        "    vec4 color = vec4(mix(partColor.rgb, instanceTint.rgb, instanceTint.a), partColor.a);\n"
+        "    if (!lighting) { gl_FrontColor = color; return; }\n"
+        "    vec4 ambient = colorMaterial ? color : gl_FrontMaterial.ambient;\n"
+        "    vec4 diffuse = colorMaterial ? color : gl_FrontMaterial.diffuse;\n"
+        "    vec3 N = gl_NormalMatrix * n;\n"
+        "    vec4 lit = gl_FrontMaterial.emission + gl_LightModel.ambient * ambient;\n"
+        "    for (int i = 0; i < 2; ++i) {\n"
+        "        if (lightEnabled[i] == 0.0) continue;\n"
+        "        vec3 L = normalize(gl_LightSource[i].position.xyz - eye.xyz * gl_LightSource[i].position.w);\n"
+        "        float nDotL = max(dot(N, L), 0.0);\n"
+        "        lit += gl_LightSource[i].ambient * ambient + gl_LightSource[i].diffuse * diffuse * nDotL;\n"
+        "        if (nDotL > 0.0) {\n"
+        "            vec3 H = normalize(L + vec3(0.0, 0.0, 1.0));\n"
+        "            lit += gl_LightSource[i].specular * gl_FrontMaterial.specular\n"
+        "                * pow(max(dot(N, H), 0.0), gl_FrontMaterial.shininess);\n"
+        "        }\n"
+        "    }\n"
+        "    gl_FrontColor = clamp(vec4(lit.rgb, diffuse.a), 0.0, 1.0);\n"
+        "}\n";
+
+    static const char* fragmentSource =
+        "#version 120\n"
+        "void main() { gl_FragColor = gl_Color; }\n";
+
+    static const char* attributes[] = { "position", "normal", "instancePosition", "instanceScale", "instanceTint" };
+    shader.program = compileProgram(vertexSource, fragmentSource, attributes, 5);
+    if (!shader.program) return shader;
+
+    GLExtensions& ext = glExtensions();
+    shader.partColor = ext.GetUniformLocation(shader.program, "partColor");
+    shader.partOffset = ext.GetUniformLocation(shader.program, "partOffset");
+    shader.partScale = ext.GetUniformLocation(shader.program, "partScale");
+    shader.lighting = ext.GetUniformLocation(shader.program, "lighting");
+    shader.colorMaterial = ext.GetUniformLocation(shader.program, "colorMaterial");
+    shader.lightEnabled = ext.GetUniformLocation(shader.program, "lightEnabled");
+    return shader;
+}
+
+class InstanceBatch {
+public:
+    void clear() {
+        instances.clear();
+    }
+
+    void add(float x, float y, float z, float angle, float scaleX, float scaleY, float scaleZ,
+        float tintR = 1.0f, float tintG = 1.0f, float tintB = 1.0f, float tint = 0.0f) {
+        instances.push_back({ x, y, z, angle, scaleX, scaleY, scaleZ, tintR, tintG, tintB, tint });
+    }
+
+    size_t size() const {
+        return instances.size();
+    }
+
+    void reserve(size_t count) {
+        instances.reserve(count);
+    }
+
+    // Streams this frame's instances to the GPU; call once after filling
+    void upload() {
+        if (!instancedShader().program || instances.empty()) return;
+        GLExtensions& ext = glExtensions();
+        if (!buffer) ext.GenBuffers(1, &buffer);
+        ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        // Re-specifying the store orphans last frame's copy instead of stalling on it
+        ext.BufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STREAM_DRAW);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Draws `mesh` once per instance with the current blend/lighting state
+    void draw(const Mesh& mesh, const float color[4], const PartTransform& part = PartTransform()) const {
+        if (instances.empty()) return;
+
+        const InstancedShader& shader = instancedShader();
+        if (!shader.program || !mesh.vertexBuffer) {
+            drawImmediate(mesh, color, part);
+            return;
+        }
+
+        GLExtensions& ext = glExtensions();
+        ext.UseProgram(shader.program);
+        ext.Uniform4fv(shader.partColor, 1, color);
+        ext.Uniform3f(shader.partOffset, part.offsetX, part.offsetY, part.offsetZ);
+        ext.Uniform3f(shader.partScale, part.scaleX, part.scaleY, part.scaleZ);
+        ext.Uniform1i(shader.lighting, glIsEnabled(GL_LIGHTING));
+        ext.Uniform1i(shader.colorMaterial, glIsEnabled(GL_COLOR_MATERIAL));
+        ext.Uniform2f(shader.lightEnabled, glIsEnabled(GL_LIGHT0) ? 1.0f : 0.0f, glIsEnabled(GL_LIGHT1) ? 1.0f : 0.0f);
+
+        ext.BindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        ext.EnableVertexAttribArray(InstancedShader::POSITION);
+        ext.EnableVertexAttribArray(InstancedShader::NORMAL);
+        ext.VertexAttribPointer(InstancedShader::POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void*)offsetof(MeshVertex, px));
+        ext.VertexAttribPointer(InstancedShader::NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void*)offsetof(MeshVertex, nx));
+
+        ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        ext.EnableVertexAttribArray(InstancedShader::INSTANCE_POSITION);
+        ext.EnableVertexAttribArray(InstancedShader::INSTANCE_SCALE);
+        ext.EnableVertexAttribArray(InstancedShader::INSTANCE_TINT);
+        ext.VertexAttribPointer(InstancedShader::INSTANCE_POSITION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)offsetof(InstanceData, x));
+        ext.VertexAttribPointer(InstancedShader::INSTANCE_SCALE, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)offsetof(InstanceData, scaleX));
+        ext.VertexAttribPointer(InstancedShader::INSTANCE_TINT, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)offsetof(InstanceData, tintR));
+        ext.VertexAttribDivisor(InstancedShader::INSTANCE_POSITION, 1);
+        ext.VertexAttribDivisor(InstancedShader::INSTANCE_SCALE, 1);
+        ext.VertexAttribDivisor(InstancedShader::INSTANCE_TINT, 1);
+
+        ext.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+        ext.DrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, (const void*)0, (GLsizei)instances.size());
+
+        for (GLuint attribute = InstancedShader::INSTANCE_POSITION; attribute <= InstancedShader::INSTANCE_TINT; ++attribute) {
+            ext.VertexAttribDivisor(attribute, 0);
+            ext.DisableVertexAttribArray(attribute);
+        }
+        ext.DisableVertexAttribArray(InstancedShader::NORMAL);
+        ext.DisableVertexAttribArray(InstancedShader::POSITION);
+        ext.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+        ext.UseProgram(0);
+    }
+
+private:
+    std::vector<InstanceData> instances; // capacity is kept across frames
+    GLuint buffer = 0;
+
+    void drawImmediate(const Mesh& mesh, const float color[4], const PartTransform& part) const {
+        for (const InstanceData& inst : instances) {
+            glColor4f(color[0] + (inst.tintR - color[0]) * inst.tint,
+                color[1] + (inst.tintG - color[1]) * inst.tint,
+                color[2] + (inst.tintB - color[2]) * inst.tint,
+                color[3]);
+            glPushMatrix();
+            glTranslatef(inst.x, inst.y, inst.z);
+            glRotatef(inst.angle, 0.0f, 1.0f, 0.0f);
+            glScalef(inst.scaleX, inst.scaleY, inst.scaleZ);
+            glTranslatef(part.offsetX, part.offsetY, part.offsetZ);
+            glScalef(part.scaleX, part.scaleY, part.scaleZ);
+            mesh.draw();
+            glPopMatrix();
+        }
+    }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+// Work-stealing job system for data-parallel passes.
+// parallelFor() cuts an index range into chunks and deals them out to one
+// queue per thread. Every thread works through its own queue newest first
+// and, once that is empty, steals the oldest chunk from another, so uneven
+// chunks still finish together. The calling thread takes part too and
+// returns once all of its chunks have run.
+//
+// A body may only write the elements of the range it is given. Each element
+// then sees the same arithmetic however the range was cut, so results are
+// identical for every thread count.
+
+#include "RingBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem {
+public:
+    static const size_t CHUNKS_PER_THREAD = 4; // spare chunks for the stealing to balance
+    static const size_t QUEUE_CAPACITY = 64;
+
+    // One thread per core by default, counting the caller
+    JobSystem() {
+        setThreadCount((int)std::thread::hardware_concurrency());
+    }
+
+    ~JobSystem() {
+        stopWorkers();
+    }
+
+    // Threads a parallelFor() runs on, including the caller; 1 runs every
+    // body inline. Call while no parallelFor() is running.
+    void setThreadCount(int threads) {
+        threads = std::max(1, threads);
+        if (threads == (int)queues.size()) return;
+        stopWorkers();
+        queues.clear();
+        for (int i = 0; i < threads; i++) queues.emplace_back(new Queue());
+        stopping = false;
+        for (int i = 1; i < threads; i++) workers.emplace_back([this, i] { work(i); });
+    }
+
+    int threadCount() const {
+        return (int)queues.size();
+    }
+
+    // Calls body(chunkBegin, chunkEnd) over [begin, end) in chunks of at
+    // least `grain` indices. Ranges of one chunk or less, and everything
+    // with a thread count of 1, run inline.
+    template <typename Body>
+    void parallelFor(size_t begin, size_t end, size_t grain, const Body& body) {
+        if (begin >= end) return;
+        size_t count = end - begin;
+        size_t chunks = std::min((count + grain - 1) / grain, queues.size() * CHUNKS_PER_THREAD);
+        if (chunks <= 1 || queues.size() == 1) {
+            body(begin, end);
+            return;
+        }
+
+        std::atomic<size_t> remaining(chunks);
+        size_t self = threadQueue();
+        for (size_t c = 0; c < chunks; c++) {
+            Job job = { &runBody<Body>, &body, begin + count * c / chunks, begin + count * (c + 1) / chunks, &remaining };
+            if (!push((self + c) % queues.size(), job)) run(job); // queue full: do it now
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex); // no worker misses the wake-up between its check and its wait
+        }
+        wake.notify_all();
+
+        Job job;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (take(self, job)) run(job);
+            else std::this_thread::yield(); // the last chunks are running elsewhere
+        }
+    }
+
+private:
+    struct Job {
+        void (*call)(const void* body, size_t begin, size_t end);
+        const void* body;
+        size_t begin, end;
+        std::atomic<size_t>* remaining; // chunks of its parallelFor() not yet finished
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        RingBuffer<Job, QUEUE_CAPACITY> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // [0] for threads outside the pool
+    std::vector<std::thread> workers;           // worker i - 1 owns queues[i]
+    std::atomic<int> pending{ 0 };              // jobs queued and not yet taken
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    template <typename Body>
+    static void runBody(const void* body, size_t begin, size_t end) {
+        (*(const Body*)body)(begin, end);
+    }
+
+    static size_t& threadQueue() {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    static void run(const Job& job) {
+        job.call(job.body, job.begin, job.end);
+        job.remaining->fetch_sub(1, std::memory_order_release);
+    }
+
+    bool push(size_t index, const Job& job) {
+        Queue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.push_back(job)) return false;
+        pending.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // The newest job in our own queue, or else the oldest in someone else's
+    bool take(size_t self, Job& job) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            Queue& queue = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.jobs.empty()) continue;
+            if (i == 0) {
+                job = queue.jobs.back();
+                queue.jobs.pop_back();
+            }
+            else {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+            }
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void work(size_t index) {
+        threadQueue() = index;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || pending.load(std::memory_order_relaxed) > 0; });
+            if (stopping) return;
+            lock.unlock();
+            Job job;
+            while (take(index, job)) run(job);
+            lock.lock();
+        }
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+        workers.clear();
+    }
+};
+
+inline JobSystem& jobSystem() {
+    static JobSystem instance;
+    return instance;
+}
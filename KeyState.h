@@ -0,0 +1,53 @@
+#pragma once
+
+// Which keys are held, written by the GLUT down/up callbacks and sampled by
+// the simulation once per tick. Holding a key therefore acts at the tick
+// rate whatever the keyboard's repeat rate, and the render thread can read
+// the same table just before drawing. A press also sets a latch that only
+// sample() clears, so a tap shorter than a tick still reaches the simulation.
+//
+// Plain keys use their character code, special keys special(key).
+
+#include <atomic>
+#include <cstdint>
+
+class KeyState {
+public:
+    static const int KEYS = 512;
+
+    static int special(int key) {
+        return 256 + (key & 255);
+    }
+
+    // Any thread; GLUT key repeats arrive as further presses
+    void press(int code) {
+        keys[code].fetch_or(HELD | PRESSED, std::memory_order_release);
+    }
+
+    void release(int code) {
+        keys[code].fetch_and((uint8_t)~HELD, std::memory_order_release);
+    }
+
+    // Lets go of everything, for when down and up events stop arriving
+    void clear() {
+        for (std::atomic<uint8_t>& key : keys) key.store(0, std::memory_order_release);
+    }
+
+    bool held(int code) const {
+        return (keys[code].load(std::memory_order_acquire) & HELD) != 0;
+    }
+
+    // Whether the key is held now; `pressed` says whether it went down since
+    // the last sample, which then starts over. One sampler per key.
+    bool sample(int code, bool& pressed) {
+        uint8_t bits = keys[code].fetch_and((uint8_t)~PRESSED, std::memory_order_acq_rel);
+        pressed = (bits & PRESSED) != 0;
+        return (bits & HELD) != 0;
+    }
+
+private:
+    static const uint8_t HELD = 1;
+    static const uint8_t PRESSED = 2;
+
+    std::atomic<uint8_t> keys[KEYS] = {};
+};
@@ -0,0 +1,367 @@
+#pragma once
+
+// Tessellate-once geometry cache.
+// GLUT/GLU regenerate every sphere, cone and cylinder vertex on each call,
+// so the games build their primitives here once at startup and replay them
+// from GPU buffers (or display lists on GL 1.1 drivers) every frame.
+// Round primitives can also be built as LOD chains, several tessellations
+// of which the one matching the object's size on screen gets drawn.
+
+#include "GLExtensions.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+struct MeshVertex {
+    float px, py, pz;
+    float nx, ny, nz;
+};
+
+struct MeshData {
+    std::vector<MeshVertex> vertices;
+    std::vector<GLuint> indices;
+};
+
+struct Mesh {
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    GLuint displayList = 0;
+    GLsizei indexCount = 0;
+
+    void draw() const {
+        if (displayList) {
+            glCallList(displayList);
+            return;
+        }
+        GLExtensions& ext = glExtensions();
+        ext.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        ext.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), (const void*)offsetof(MeshVertex, px));
+        glNormalPointer(GL_FLOAT, sizeof(MeshVertex), (const void*)offsetof(MeshVertex, nx));
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)0);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        ext.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+// ===== Tessellation =====
+// Same orientation as the GLUT/GLU shapes they replace: sphere poles and
+// cone/cylinder axes run along +z, triangles wind counter-clockwise outward.
+
+const float MESH_PI = 3.14159265f;
+
+inline void addGridIndices(MeshData& data, GLuint first, int columns, int rows) {
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < columns; ++c) {
+            GLuint a = first + r * (columns + 1) + c;
+            GLuint b = a + columns + 1;
+            data.indices.push_back(a);
+            data.indices.push_back(b);
+            data.indices.push_back(a + 1);
+            data.indices.push_back(a + 1);
+            data.indices.push_back(b);
+            data.indices.push_back(b + 1);
+        }
+    }
+}
+
+inline MeshData tessellateSphere(float radius, int slices, int stacks) {
+    MeshData data;
+    for (int i = 0; i <= stacks; ++i) {
+        float phi = MESH_PI * i / stacks;
+        for (int j = 0; j <= slices; ++j) {
+            float theta = 2.0f * MESH_PI * j / slices;
+            float nx = sinf(phi) * cosf(theta);
+            float ny = sinf(phi) * sinf(theta);
+            float nz = cosf(phi);
+            data.vertices.push_back({ nx * radius, ny * radius, nz * radius, nx, ny, nz });
+        }
+    }
+    addGridIndices(data, 0, slices, stacks);
+    return data;
+}
+
+// Open tube from z = 0 to z = height, like gluCylinder
+inline MeshData tessellateCylinder(float baseRadius, float topRadius, float height, int slices, int stacks) {
+    MeshData data;
+    float slope = (baseRadius - topRadius) / height;
+    float normalScale = 1.0f / sqrtf(1.0f + slope * slope);
+    // Rows run top to bottom so the shared grid winding faces outward
+    for (int i = 0; i <= stacks; ++i) {
+        float t = 1.0f - (float)i / stacks;
+        float radius = baseRadius + (topRadius - baseRadius) * t;
+        for (int j = 0; j <= slices; ++j) {
+            float theta = 2.0f * MESH_PI * j / slices;
+            float c = cosf(theta), s = sinf(theta);
+            data.vertices.push_back({ c * radius, s * radius, t * height,
+                c * normalScale, s * normalScale, slope * normalScale });
+        }
+    }
+    addGridIndices(data, 0, slices, stacks);
+    return data;
+}
+
+// Closed cone with its base disc at z = 0 and apex at z = height, like glutSolidCone
+inline MeshData tessellateCone(float base, float height, int slices, int stacks) {
+    MeshData data = tessellateCylinder(base, 0.0f, height, slices, stacks);
+
+    GLuint center = (GLuint)data.vertices.size();
+    data.vertices.push_back({ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f });
+    for (int j = 0; j <= slices; ++j) {
+        float theta = 2.0f * MESH_PI * j / slices;
+        data.vertices.push_back({ cosf(theta) * base, sinf(theta) * base, 0.0f, 0.0f, 0.0f, -1.0f });
+    }
+    for (int j = 0; j < slices; ++j) {
+        data.indices.push_back(center);
+        data.indices.push_back(center + 2 + j);
+        data.indices.push_back(center + 1 + j);
+    }
+    return data;
+}
+
+inline MeshData tessellateCube(float size) {
+    static const float faces[6][3] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+    };
+    MeshData data;
+    float h = size / 2.0f;
+    for (int f = 0; f < 6; ++f) {
+        float n[3] = { faces[f][0], faces[f][1], faces[f][2] };
+        // Two axes spanning the face; v = n x u so that u x v = n
+        float u[3] = { n[0] != 0.0f ? 0.0f : 1.0f, n[0] != 0.0f ? 1.0f : 0.0f, 0.0f };
+        float v[3] = { n[1] * u[2] - n[2] * u[1], n[2] * u[0] - n[0] * u[2], n[0] * u[1] - n[1] * u[0] };
+        GLuint first = (GLuint)data.vertices.size();
+        static const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+        for (int k = 0; k < 4; ++k) {
+            float a = corners[k][0], b = corners[k][1];
+            data.vertices.push_back({
+                (n[0] + a * u[0] + b * v[0]) * h,
+                (n[1] + a * u[1] + b * v[1]) * h,
+                (n[2] + a * u[2] + b * v[2]) * h,
+                n[0], n[1], n[2] });
+        }
+        GLuint quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+        data.indices.insert(data.indices.end(), quad, quad + 6);
+    }
+    return data;
+}
+
+// ===== Composition =====
+// Used to fold a ship's repeated parts (paired lights, flames) into one mesh.
+
+inline void appendMeshData(MeshData& dst, const MeshData& src, float offsetX, float offsetY, float offsetZ) {
+    GLuint first = (GLuint)dst.vertices.size();
+    for (const MeshVertex& v : src.vertices) {
+        dst.vertices.push_back({ v.px + offsetX, v.py + offsetY, v.pz + offsetZ, v.nx, v.ny, v.nz });
+    }
+    for (GLuint index : src.indices) {
+        dst.indices.push_back(first + index);
+    }
+}
+
+// Same as glRotatef(180, 1, 0, 0) applied to the geometry
+inline void rotateMeshDataX180(MeshData& data) {
+    for (MeshVertex& v : data.vertices) {
+        v.py = -v.py;
+        v.pz = -v.pz;
+        v.ny = -v.ny;
+        v.nz = -v.nz;
+    }
+}
+
+// ===== Upload =====
+
+inline Mesh uploadMesh(const MeshData& data) {
+    Mesh mesh;
+    mesh.indexCount = (GLsizei)data.indices.size();
+
+    GLExtensions& ext = loadGLExtensions();
+    if (ext.hasVertexBuffers()) {
+        ext.GenBuffers(1, &mesh.vertexBuffer);
+        ext.BindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        ext.BufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(MeshVertex), data.vertices.data(), GL_STATIC_DRAW);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+        ext.GenBuffers(1, &mesh.indexBuffer);
+        ext.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+        ext.BufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(GLuint), data.indices.data(), GL_STATIC_DRAW);
+        ext.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        return mesh;
+    }
+
+    // Display-list fallback for drivers without buffer objects
+    mesh.displayList = glGenLists(1);
+    glNewList(mesh.displayList, GL_COMPILE);
+    glBegin(GL_TRIANGLES);
+    for (GLuint index : data.indices) {
+        const MeshVertex& v = data.vertices[index];
+        glNormal3f(v.nx, v.ny, v.nz);
+        glVertex3f(v.px, v.py, v.pz);
+    }
+    glEnd();
+    glEndList();
+    return mesh;
+}
+
+// ===== Level of detail =====
+// An n-sided outline inscribed in a circle of r pixels strays up to
+// r * (1 - cos(pi / n)) ~= r * pi^2 / (2 n^2) pixels from it, so each draw
+// uses the coarsest level whose silhouette stays within LOD_MAX_ERROR_PIXELS
+// of the true shape. Every level halves the slices and stacks of the one
+// before it, down to a floor where the shape would stop reading as round.
+
+const int LOD_LEVELS = 4;
+const float LOD_MAX_ERROR_PIXELS = 0.25f;
+const int LOD_MIN_SLICES = 6;
+const int LOD_MIN_STACKS = 3;
+
+inline int lodDivisions(int full, int level, int minimum) {
+    return std::max(std::min(full, minimum), full >> level);
+}
+
+// The current transform and viewport, read once and reused to size any
+// number of objects on screen
+struct LodView {
+    float modelview[16];
+    float pixelsPerUnit; // screen pixels per eye-space unit at distance 1 (or anywhere, for ortho)
+    bool perspective;
+
+    static LodView current() {
+        LodView view;
+        float projection[16];
+        GLint viewport[4];
+        glGetFloatv(GL_MODELVIEW_MATRIX, view.modelview);
+        glGetFloatv(GL_PROJECTION_MATRIX, projection);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        view.pixelsPerUnit = projection[5] * viewport[3] * 0.5f;
+        view.perspective = projection[15] == 0.0f;
+        return view;
+    }
+
+    // Projected radius of a sphere at (x, y, z) in the current model space
+    float pixelRadius(float x, float y, float z, float radius) const {
+        const float* m = modelview;
+        // Largest axis scale, so a glScalef-stretched mesh is sized by its long side
+        float scale = std::max(m[0] * m[0] + m[1] * m[1] + m[2] * m[2],
+            std::max(m[4] * m[4] + m[5] * m[5] + m[6] * m[6], m[8] * m[8] + m[9] * m[9] + m[10] * m[10]));
+        float r = radius * sqrtf(scale);
+        if (!perspective) return r * pixelsPerUnit;
+        float depth = -(m[2] * x + m[6] * y + m[10] * z + m[14]);
+        if (depth <= r) return FLT_MAX; // reaches the camera plane: full detail
+        return r * pixelsPerUnit / depth;
+    }
+};
+
+struct LodMesh {
+    const Mesh* levels[LOD_LEVELS]; // finest first
+    int slices[LOD_LEVELS];
+    float radius = 0.0f;            // bounds every level, in mesh units
+
+    int levelFor(float pixelRadius) const {
+        for (int level = LOD_LEVELS - 1; level > 0; --level) {
+            float n = (float)slices[level];
+            if (pixelRadius * MESH_PI * MESH_PI / (2.0f * n * n) <= LOD_MAX_ERROR_PIXELS) return level;
+        }
+        return 0;
+    }
+
+    const Mesh& level(int level) const {
+        return *levels[level];
+    }
+
+    // Draws the level suited to the current matrices and viewport
+    void draw() const {
+        levels[levelFor(LodView::current().pixelRadius(0.0f, 0.0f, 0.0f, radius))]->draw();
+    }
+};
+
+// ===== Cache =====
+// Meshes are keyed by shape and parameters so both games (and later the
+// arcade host) share a single copy of each primitive.
+
+class MeshCache {
+public:
+    const Mesh& sphere(float radius, int slices, int stacks) {
+        return find(SPHERE, radius, 0.0f, 0.0f, slices, stacks);
+    }
+
+    const Mesh& cone(float base, float height, int slices, int stacks) {
+        return find(CONE, base, 0.0f, height, slices, stacks);
+    }
+
+    const Mesh& cylinder(float baseRadius, float topRadius, float height, int slices, int stacks) {
+        return find(CYLINDER, baseRadius, topRadius, height, slices, stacks);
+    }
+
+    const Mesh& cube(float size) {
+        return find(CUBE, size, 0.0f, 0.0f, 0, 0);
+    }
+
+    LodMesh sphereLod(float radius, int slices, int stacks) {
+        LodMesh lod;
+        lod.radius = radius;
+        for (int level = 0; level < LOD_LEVELS; ++level) {
+            lod.slices[level] = lodDivisions(slices, level, LOD_MIN_SLICES);
+            lod.levels[level] = &sphere(radius, lod.slices[level], lodDivisions(stacks, level, LOD_MIN_STACKS));
+        }
+        return lod;
+    }
+
+    LodMesh coneLod(float base, float height, int slices, int stacks) {
+        LodMesh lod;
+        lod.radius = sqrtf(base * base + height * height);
+        for (int level = 0; level < LOD_LEVELS; ++level) {
+            lod.slices[level] = lodDivisions(slices, level, LOD_MIN_SLICES);
+            lod.levels[level] = &cone(base, height, lod.slices[level], lodDivisions(stacks, level, 1));
+        }
+        return lod;
+    }
+
+    // Uploads caller-composed geometry; never shared by lookup
+    const Mesh& composite(const MeshData& data) {
+        entries.push_back({ COMPOSITE, 0.0f, 0.0f, 0.0f, 0, 0, uploadMesh(data) });
+        return entries.back().mesh;
+    }
+
+private:
+    enum Shape { SPHERE, CONE, CYLINDER, CUBE, COMPOSITE };
+
+    struct Entry {
+        Shape shape;
+        float a, b, c;
+        int slices, stacks;
+        Mesh mesh;
+    };
+
+    std::deque<Entry> entries; // deque keeps returned references stable
+
+    const Mesh& find(Shape shape, float a, float b, float c, int slices, int stacks) {
+        for (const Entry& e : entries) {
+            if (e.shape == shape && shape != COMPOSITE && e.a == a && e.b == b && e.c == c && e.slices == slices && e.stacks == stacks) {
+                return e.mesh;
+            }
+        }
+
+        MeshData data;
+        switch (shape) {
+        case SPHERE: data = tessellateSphere(a, slices, stacks); break;
+        case CONE: data = tessellateCone(a, c, slices, stacks); break;
+        case CYLINDER: data = tessellateCylinder(a, b, c, slices, stacks); break;
+        case CUBE: data = tessellateCube(a); break;
+        case COMPOSITE: break;
+        }
+        entries.push_back({ shape, a, b, c, slices, stacks, uploadMesh(data) });
+        return entries.back().mesh;
+    }
+};
+
+inline MeshCache& meshCache() {
+    static MeshCache cache;
+    return cache;
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+// Pooled particle system.
+// Particles are stored as parallel arrays in a fixed-capacity pool and are
+// spawned once with their velocity, lifetime, colour and size curve, so
+// update() is a branch-free integration loop, split across the job system
+// for large pools, plus a swap-remove pass, and never allocates. draw()
+// streams every live particle as one additive batch of point sprites sized
+// in world units. Without shader support the batch falls back to
+// fixed-size points.
+
+#include "GLExtensions.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <vector>
+
+struct ParticleSpawn {
+    float x, y, z;
+    float vx = 0.0f, vy = 0.0f, vz = 0.0f;
+    float life = 1.0f;                      // seconds
+    float r = 1.0f, g = 1.0f, b = 1.0f;
+    float alphaStart = 1.0f, alphaEnd = 0.0f;
+    float sizeStart = 0.1f, sizeEnd = 0.1f; // world units, across
+};
+
+class ParticleSystem {
+public:
+    static const size_t UPDATE_GRAIN = 8192; // particles per job; smaller pools update inline
+
+    // Only a pool that draws builds vertices, and sizes them on its first draw
+    explicit ParticleSystem(size_t capacity)
+        : capacity(capacity), pool(FIELD_COUNT * capacity) {
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // Copies another pool's live particles, for example to publish a
+    // snapshot of them to another thread; this pool's GL objects are left alone
+    void copyFrom(const ParticleSystem& other) {
+        count = std::min(other.count, capacity);
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            std::copy(other.field((Field)f), other.field((Field)f) + count, field((Field)f));
+        }
+    }
+
+    // Returns false when the pool is full and the particle was dropped
+    bool spawn(const ParticleSpawn& p) {
+        if (count == capacity) return false;
+        size_t i = count++;
+        field(X)[i] = p.x;
+        field(Y)[i] = p.y;
+        field(Z)[i] = p.z;
+        field(VX)[i] = p.vx;
+        field(VY)[i] = p.vy;
+        field(VZ)[i] = p.vz;
+        field(AGE)[i] = 0.0f;
+        field(INV_LIFE)[i] = 1.0f / p.life;
+        field(R)[i] = p.r;
+        field(G)[i] = p.g;
+        field(B)[i] = p.b;
+        field(ALPHA_START)[i] = p.alphaStart;
+        field(ALPHA_DELTA)[i] = p.alphaEnd - p.alphaStart;
+        field(SIZE_START)[i] = p.sizeStart;
+        field(SIZE_DELTA)[i] = p.sizeEnd - p.sizeStart;
+        return true;
+    }
+
+    void update(float deltaTime) {
+        float* x = field(X);
+        float* y = field(Y);
+        float* z = field(Z);
+        const float* vx = field(VX);
+        const float* vy = field(VY);
+        const float* vz = field(VZ);
+        float* age = field(AGE);
+        const float* invLife = field(INV_LIFE);
+
+        // Ages are kept as 0..1 of the lifetime
+        jobSystem().parallelFor(0, count, UPDATE_GRAIN, [=](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                x[i] += vx[i] * deltaTime;
+                y[i] += vy[i] * deltaTime;
+                z[i] += vz[i] * deltaTime;
+                age[i] += invLife[i] * deltaTime;
+            }
+        });
+
+        // Draw order doesn't matter with additive blending, so the dead
+        // are replaced by the last live particle
+        for (size_t i = 0; i < count; ) {
+            if (age[i] >= 1.0f) {
+                count--;
+                for (int f = 0; f < FIELD_COUNT; f++) {
+                    field((Field)f)[i] = field((Field)f)[count];
+                }
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
+    // `ahead` extrapolates positions by that many seconds past the last
+    // update, for rendering between simulation ticks
+    void draw(float ahead = 0.0f) {
+        draw(*this, ahead);
+    }
+
+    // Draws another pool's live particles with this pool's GL objects, for
+    // example a snapshot the simulation thread published, without copying it
+    void draw(const ParticleSystem& particles, float ahead) {
+        if (vertices.capacity() < particles.capacity * FLOATS_PER_VERTEX) {
+            vertices.reserve(particles.capacity * FLOATS_PER_VERTEX);
+        }
+        if (particles.count == 0) return;
+        if (!initialized) init();
+
+        vertices.resize(particles.count * FLOATS_PER_VERTEX);
+        float* out = vertices.data();
+        for (size_t i = 0; i < particles.count; i++) {
+            float t = std::min(1.0f, particles.field(AGE)[i] + particles.field(INV_LIFE)[i] * ahead);
+            *out++ = particles.field(X)[i] + particles.field(VX)[i] * ahead;
+            *out++ = particles.field(Y)[i] + particles.field(VY)[i] * ahead;
+            *out++ = particles.field(Z)[i] + particles.field(VZ)[i] * ahead;
+            *out++ = particles.field(SIZE_START)[i] + particles.field(SIZE_DELTA)[i] * t;
+            *out++ = particles.field(R)[i];
+            *out++ = particles.field(G)[i];
+            *out++ = particles.field(B)[i];
+            *out++ = particles.field(ALPHA_START)[i] + particles.field(ALPHA_DELTA)[i] * t;
+        }
+
+        glDisable(GL_LIGHTING);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glDepthMask(GL_FALSE);
+        if (program) {
+            drawSprites();
+        }
+        else {
+            drawPoints();
+        }
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glEnable(GL_LIGHTING);
+    }
+
+private:
+    static const int FLOATS_PER_VERTEX = 8; // x, y, z, size, r, g, b, a
+    enum Attribute { POSITION, COLOR };
+    enum Field {
+        X, Y, Z, VX, VY, VZ, AGE, INV_LIFE,
+        R, G, B, ALPHA_START, ALPHA_DELTA, SIZE_START, SIZE_DELTA,
+        FIELD_COUNT
+    };
+
+    size_t capacity;
+    size_t count = 0;
+    std::vector<float> pool;     // one array of `capacity` floats per Field
+    std::vector<float> vertices; // interleaved, rebuilt each draw; vertexCount() of them
+
+    bool initialized = false;
+    GLuint program = 0;
+    GLuint buffer = 0;
+    GLint pointScaleUniform = -1;
+
+    float* field(Field f) {
+        return pool.data() + f * capacity;
+    }
+
+    GLsizei vertexCount() const {
+        return (GLsizei)(vertices.size() / FLOATS_PER_VERTEX);
+    }
+
+    const float* field(Field f) const {
+        return pool.data() + f * capacity;
+    }
+
+    void init() {
+        initialized = true;
+        GLExtensions& ext = loadGLExtensions();
+        if (!ext.hasShaders() || !ext.hasVertexBuffers()) return;
+
+        static const char* vertexSource =
+            "#version 120\n"
+            "attribute vec4 position;\n" // xyz, w = size in world units
+            "attribute vec4 color;\n"
+            "uniform float pointScale;\n" // pixels per world unit at eye distance 1
+            "void main() {\n"
+            "    vec4 eye = gl_ModelViewMatrix * vec4(position.xyz, 1.0);\n"
+            "    gl_Position = gl_ProjectionMatrix * eye;\n"
+            "    gl_PointSize = max(1.0, position.w * pointScale / -eye.z);\n"
+            "    gl_FrontColor = color;\n"
+            "}\n";
+        // Round sprites with a one-pixel-ish soft edge, flat like the unlit spheres they replace
+        static const char* fragmentSource =
+            "#version 120\n"
+            "void main() {\n"
+            "    vec2 d = gl_PointCoord * 2.0 - 1.0;\n"
+            "    float r = length(d);\n"
+            "    if (r > 1.0) discard;\n"
+            "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * clamp((1.0 - r) * 8.0, 0.0, 1.0));\n"
+            "}\n";
+        static const char* attributes[] = { "position", "color" };
+
+        program = compileProgram(vertexSource, fragmentSource, attributes, 2);
+        if (!program) return;
+        pointScaleUniform = ext.GetUniformLocation(program, "pointScale");
+        ext.GenBuffers(1, &buffer);
+    }
+
+    void drawSprites() {
+        // Projected size of one world unit, from the current projection and viewport
+        GLfloat projection[16];
+        GLint viewport[4];
+        glGetFloatv(GL_PROJECTION_MATRIX, projection);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        float pointScale = projection[5] * viewport[3] * 0.5f;
+
+        GLExtensions& ext = glExtensions();
+        ext.UseProgram(program);
+        ext.Uniform1f(pointScaleUniform, pointScale);
+        glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+        glEnable(GL_POINT_SPRITE);
+
+        GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+        ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        // Re-specifying the store orphans last frame's copy instead of stalling on it
+        ext.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+        ext.EnableVertexAttribArray(POSITION);
+        ext.EnableVertexAttribArray(COLOR);
+        ext.VertexAttribPointer(POSITION, 4, GL_FLOAT, GL_FALSE, stride, (const void*)0);
+        ext.VertexAttribPointer(COLOR, 4, GL_FLOAT, GL_FALSE, stride, (const void*)(4 * sizeof(float)));
+        glDrawArrays(GL_POINTS, 0, vertexCount());
+        ext.DisableVertexAttribArray(COLOR);
+        ext.DisableVertexAttribArray(POSITION);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glDisable(GL_POINT_SPRITE);
+        glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+        ext.UseProgram(0);
+    }
+
+    void drawPoints() {
+        GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+        glPointSize(3.0f);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, vertices.data());
+        glColorPointer(4, GL_FLOAT, stride, vertices.data() + 4);
+        glDrawArrays(GL_POINTS, 0, vertexCount());
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+};
@@ -0,0 +1,442 @@
+#pragma once
+
+// Frame profiler.
+// ProfileZone times a scope on the CPU; GpuProfileZone also brackets it with
+// GL timestamp queries, which are read back a few frames later so the CPU
+// never waits on the GPU. Every zone keeps its per-frame totals for the last
+// HISTORY frames, and the overlay shows their p50/p99 next to a frame-time
+// graph. With a trace file set, each zone instance is also recorded and the
+// timeline is written as Chrome trace JSON at exit (chrome://tracing or
+// ui.perfetto.dev). CPU zones may be timed on any thread; GPU zones and the
+// overlay belong to the thread that owns the GL context.
+
+#include "GLExtensions.h"
+#include "TextRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+class Profiler {
+public:
+    static const int HISTORY = 240;    // frames kept for percentiles and the graph
+    static const int GPU_LATENCY = 4;  // frames of timestamp queries in flight
+    static const size_t MAX_TRACE_EVENTS = 1 << 21;
+
+    // Zones cost two clock reads each; headless runs switch this off unless tracing
+    bool enabled = true;
+
+    Profiler() : epoch(std::chrono::steady_clock::now()) {
+    }
+
+    // Seconds since the profiler was created
+    double now() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // Closes the previous frame's zone totals and starts the next frame
+    void beginFrame() {
+        if (!enabled) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        double t = now();
+        if (frameStarted) {
+            int slot = frame % HISTORY;
+            frameTimes[slot] = (float)(t - frameStart);
+            for (Zone& zone : zones) {
+                zone.cpuHistory[slot] = (float)zone.cpuTotal;
+                zone.cpuTotal = 0.0;
+            }
+            frame++;
+        }
+        frameStarted = true;
+        frameStart = t;
+        collectGpuFrame(gpuFrames[frame % GPU_LATENCY]);
+    }
+
+    int zoneIndex(const char* name, bool gpu) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < zones.size(); i++) {
+            if (zones[i].name == name || strcmp(zones[i].name, name) == 0) {
+                zones[i].gpu = zones[i].gpu || gpu;
+                return (int)i;
+            }
+        }
+        zones.push_back(Zone());
+        zones.back().name = name;
+        zones.back().gpu = gpu;
+        return (int)zones.size() - 1;
+    }
+
+    void leaveZone(int index, double start) {
+        double end = now();
+        std::lock_guard<std::mutex> lock(mutex);
+        Zone& zone = zones[index];
+        zone.cpuTotal += end - start;
+        if (tracing) addTraceEvent(zone.name, threadTrack(), start, end - start);
+    }
+
+    // Gives the calling thread a trace track of its own; zones timed on
+    // threads that never call this go on the main CPU track
+    void nameThread(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t i = 0;
+        while (i < threadNames.size() && strcmp(threadNames[i], name) != 0) i++;
+        if (i == threadNames.size()) threadNames.push_back(name);
+        threadTrack() = FIRST_THREAD_TRACK + (int)i;
+    }
+
+    // Timestamp queries are only issued while someone will read them
+    int beginGpuZone(int index, double cpuStart) {
+        if (!frameStarted || !(overlayVisible || tracing)) return -1;
+        GLExtensions& ext = loadGLExtensions();
+        if (!ext.hasTimerQueries()) return -1;
+
+        GpuFrame& gpuFrame = gpuFrames[frame % GPU_LATENCY];
+        GpuRange range;
+        range.zone = index;
+        range.begin = nextQuery(gpuFrame);
+        range.end = range.begin;
+        range.cpuStart = cpuStart;
+        ext.QueryCounter(gpuFrame.queries[range.begin], GL_TIMESTAMP);
+        gpuFrame.ranges.push_back(range);
+        return (int)gpuFrame.ranges.size() - 1;
+    }
+
+    void endGpuZone(int handle) {
+        GpuFrame& gpuFrame = gpuFrames[frame % GPU_LATENCY];
+        GpuRange& range = gpuFrame.ranges[handle];
+        range.end = nextQuery(gpuFrame);
+        glExtensions().QueryCounter(gpuFrame.queries[range.end], GL_TIMESTAMP);
+    }
+
+    void toggleOverlay() {
+        overlayVisible = !overlayVisible;
+    }
+
+    // The overlay changes every frame, so a frame showing it is never still
+    bool overlayShown() const {
+        return overlayVisible && enabled;
+    }
+
+    // Zone table at the top right and the frame-time graph below it, over a
+    // viewport of the given size
+    void drawOverlay(int width, int height) {
+        if (!overlayVisible || !enabled) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        float left = width - 330.0f;
+        float top = height - 24.0f;
+
+        // Text is re-laid-out a few times a second rather than every frame
+        if (frame - textFrame >= TEXT_REFRESH_FRAMES || textLines.empty()) {
+            textFrame = frame;
+            layoutText(left, top);
+        }
+        text.draw(width, height);
+        drawGraph(left, top - LINE_HEIGHT * (zones.size() + 1) - GRAPH_HEIGHT - 8.0f);
+    }
+
+    void setTraceFile(const char* path) {
+        tracePath = path;
+        tracing = true;
+        enabled = true;
+    }
+
+    bool isTracing() const {
+        return tracing;
+    }
+
+    // Writes the recorded timeline; returns false if it couldn't be saved
+    bool writeTrace() {
+        if (!tracing) return true;
+        std::lock_guard<std::mutex> lock(mutex);
+        FILE* file = fopen(tracePath, "w");
+        if (!file) {
+            fprintf(stderr, "Could not write trace to %s\n", tracePath);
+            return false;
+        }
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU\"}},\n", CPU_TRACK);
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+        for (size_t i = 0; i < threadNames.size(); i++) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                FIRST_THREAD_TRACK + (int)i, threadNames[i]);
+        }
+        for (const TraceEvent& event : traceEvents) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                event.name, event.track, event.start * 1e6, event.duration * 1e6);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        printf("Wrote %zu trace events to %s%s\n", traceEvents.size(), tracePath,
+            traceEvents.size() == MAX_TRACE_EVENTS ? " (limit reached, later events dropped)" : "");
+        return true;
+    }
+
+private:
+    static const int CPU_TRACK = 1;
+    static const int GPU_TRACK = 2;
+    static const int FIRST_THREAD_TRACK = 3; // then one per nameThread() name
+    static const int TEXT_REFRESH_FRAMES = 15;
+    static const int LINE_HEIGHT = 20;
+    static const int GRAPH_HEIGHT = 60;
+    static constexpr float GRAPH_MAX_SECONDS = 1.0f / 30.0f; // top of the graph
+
+    struct Zone {
+        const char* name = "";
+        bool gpu = false;
+        double cpuTotal = 0.0;  // seconds in the current frame
+        int gpuSamples = 0;
+        float cpuHistory[HISTORY] = {};
+        float gpuHistory[HISTORY] = {};
+    };
+
+    struct GpuRange {
+        int zone;
+        size_t begin, end;  // indices into GpuFrame::queries
+        double cpuStart;    // lines the GPU track up with the CPU one
+    };
+
+    struct GpuFrame {
+        int frame = 0;
+        size_t used = 0;
+        std::vector<GLuint> queries;
+        std::vector<GpuRange> ranges;
+    };
+
+    struct TraceEvent {
+        const char* name;
+        int track;
+        double start, duration;
+    };
+
+    std::chrono::steady_clock::time_point epoch;
+    std::mutex mutex; // guards the zones and trace against zones timed on other threads
+    std::vector<Zone> zones;
+    float frameTimes[HISTORY] = {};
+    int frame = 0;
+    bool frameStarted = false;
+    double frameStart = 0.0;
+    GpuFrame gpuFrames[GPU_LATENCY];
+
+    bool overlayVisible = false;
+    TextBatch text;
+    std::vector<int> textLines;  // handles, two per row: label and figures
+    int textFrame = 0;
+    std::vector<float> graph;
+    std::vector<float> scratch;
+
+    bool tracing = false;
+    const char* tracePath = "";
+    std::vector<TraceEvent> traceEvents;
+    std::vector<const char*> threadNames;
+
+    static int& threadTrack() {
+        static thread_local int track = CPU_TRACK;
+        return track;
+    }
+
+    void addTraceEvent(const char* name, int track, double start, double duration) {
+        if (traceEvents.size() == MAX_TRACE_EVENTS) return;
+        TraceEvent event = { name, track, start, duration };
+        traceEvents.push_back(event);
+    }
+
+    size_t nextQuery(GpuFrame& gpuFrame) {
+        if (gpuFrame.used == gpuFrame.queries.size()) {
+            GLuint query = 0;
+            glExtensions().GenQueries(1, &query);
+            gpuFrame.queries.push_back(query);
+        }
+        return gpuFrame.used++;
+    }
+
+    // Reads back the queries a slot issued GPU_LATENCY frames ago, then
+    // hands the slot to the current frame. Results that still aren't ready
+    // are dropped rather than waited for.
+    void collectGpuFrame(GpuFrame& gpuFrame) {
+        if (!gpuFrame.ranges.empty()) {
+            GLExtensions& ext = glExtensions();
+            GLint available = 0;
+            ext.GetQueryObjectiv(gpuFrame.queries[gpuFrame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                int slot = gpuFrame.frame % HISTORY;
+                for (const GpuRange& range : gpuFrame.ranges) zones[range.zone].gpuHistory[slot] = 0.0f;
+
+                uint64_t origin = 0;
+                for (size_t i = 0; i < gpuFrame.ranges.size(); i++) {
+                    const GpuRange& range = gpuFrame.ranges[i];
+                    uint64_t begin = 0, end = 0;
+                    ext.GetQueryObjectui64v(gpuFrame.queries[range.begin], GL_QUERY_RESULT, &begin);
+                    ext.GetQueryObjectui64v(gpuFrame.queries[range.end], GL_QUERY_RESULT, &end);
+                    double duration = (end - begin) * 1e-9;
+                    zones[range.zone].gpuHistory[slot] += (float)duration;
+                    if (tracing) {
+                        if (i == 0) origin = begin;
+                        double start = gpuFrame.ranges[0].cpuStart + (begin - origin) * 1e-9;
+                        addTraceEvent(zones[range.zone].name, GPU_TRACK, start, duration);
+                    }
+                }
+                for (const GpuRange& range : gpuFrame.ranges) {
+                    Zone& zone = zones[range.zone];
+                    if (zone.gpuSamples < HISTORY) zone.gpuSamples++;
+                }
+            }
+        }
+        gpuFrame.frame = frame;
+        gpuFrame.used = 0;
+        gpuFrame.ranges.clear();
+    }
+
+    float percentile(const float* history, int count, float fraction) {
+        if (count == 0) return 0.0f;
+        scratch.assign(history, history + count);
+        size_t rank = std::min((size_t)(fraction * count), scratch.size() - 1);
+        std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+        return scratch[rank];
+    }
+
+    void setRow(size_t row, float x, float y, const char* label, const char* figures) {
+        while (textLines.size() < (row + 1) * 2) {
+            textLines.push_back(text.addLine(1.0f, 1.0f, 0.6f));
+        }
+        text.setText(textLines[row * 2], x, y, label);
+        text.setText(textLines[row * 2 + 1], x + 130.0f, y, figures);
+    }
+
+    void layoutText(float left, float top) {
+        int frames = std::min(frame, (int)HISTORY);
+        char figures[96];
+        snprintf(figures, sizeof(figures), "p50 %.2f  p99 %.2f ms",
+            percentile(frameTimes, frames, 0.5f) * 1000.0f, percentile(frameTimes, frames, 0.99f) * 1000.0f);
+        setRow(0, left, top, "frame", figures);
+
+        for (size_t i = 0; i < zones.size(); i++) {
+            Zone& zone = zones[i];
+            int length = snprintf(figures, sizeof(figures), "%.2f / %.2f",
+                percentile(zone.cpuHistory, frames, 0.5f) * 1000.0f, percentile(zone.cpuHistory, frames, 0.99f) * 1000.0f);
+            if (zone.gpu && zone.gpuSamples > 0) {
+                int samples = std::min(zone.gpuSamples, (int)HISTORY);
+                snprintf(figures + length, sizeof(figures) - length, "   gpu %.2f / %.2f",
+                    percentile(zone.gpuHistory, samples, 0.5f) * 1000.0f, percentile(zone.gpuHistory, samples, 0.99f) * 1000.0f);
+            }
+            setRow(i + 1, left, top - LINE_HEIGHT * (i + 1.0f), zone.name, figures);
+        }
+    }
+
+    // One pixel per frame, oldest on the left, with guides at 60 and 30 Hz
+    void drawGraph(float left, float bottom) {
+        float right = left + HISTORY;
+        float top = bottom + GRAPH_HEIGHT;
+        float sixty = bottom + GRAPH_HEIGHT * (1.0f / 60.0f) / GRAPH_MAX_SECONDS;
+        graph.assign({
+            left, bottom, right, bottom, right, top, left, top,  // backdrop
+            left, sixty, right, sixty,                           // 16.7 ms
+            left, top, right, top                                // 33.3 ms
+        });
+        int frames = std::min(frame, (int)HISTORY);
+        for (int i = 0; i < frames; i++) {
+            float seconds = frameTimes[(frame - frames + i) % HISTORY];
+            graph.push_back(left + i);
+            graph.push_back(bottom + GRAPH_HEIGHT * std::min(1.0f, seconds / GRAPH_MAX_SECONDS));
+        }
+
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glOrtho(0, viewport[2], 0, viewport[3], -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, graph.data());
+        glColor4f(0.0f, 0.0f, 0.0f, 0.5f);
+        glDrawArrays(GL_QUADS, 0, 4);
+        glColor4f(0.3f, 0.8f, 0.3f, 0.8f);
+        glDrawArrays(GL_LINES, 4, 2);
+        glColor4f(0.8f, 0.3f, 0.3f, 0.8f);
+        glDrawArrays(GL_LINES, 6, 2);
+        if (frames > 1) {
+            glColor4f(1.0f, 1.0f, 0.6f, 1.0f);
+            glDrawArrays(GL_LINE_STRIP, 8, frames);
+        }
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        glPopAttrib();
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// Records the whole run and writes it to `path` when the program exits
+inline void startProfilerTrace(const char* path) {
+    profiler().setTraceFile(path);
+    atexit([] { profiler().writeTrace(); });
+}
+
+// Times the enclosing scope
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) {
+        Profiler& p = profiler();
+        if (!p.enabled) return;
+        index = p.zoneIndex(name, false);
+        start = p.now();
+    }
+
+    ~ProfileZone() {
+        if (index >= 0) profiler().leaveZone(index, start);
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    int index = -1;
+    double start = 0.0;
+};
+
+// Times the enclosing scope on the CPU and the GL commands it issues on the GPU
+class GpuProfileZone {
+public:
+    explicit GpuProfileZone(const char* name) {
+        Profiler& p = profiler();
+        if (!p.enabled) return;
+        index = p.zoneIndex(name, true);
+        start = p.now();
+        gpuHandle = p.beginGpuZone(index, start);
+    }
+
+    ~GpuProfileZone() {
+        if (index < 0) return;
+        Profiler& p = profiler();
+        if (gpuHandle >= 0) p.endGpuZone(gpuHandle);
+        p.leaveZone(index, start);
+    }
+
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+    int index = -1;
+    int gpuHandle = -1;
+    double start = 0.0;
+};
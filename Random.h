@@ -0,0 +1,98 @@
+#pragma once
+
+// Deterministic random numbers for the games.
+// Every subsystem draws from its own xoshiro128** stream, all derived from
+// one game seed, so a run is reproducible from its seed and one subsystem
+// consuming more numbers never shifts another's sequence. Rendering never
+// touches a stream: visual jitter is hashed from (entity id, frame, index)
+// and costs a few integer ops.
+
+#include <cstdint>
+#include <ctime>
+
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Fresh seed for a normal play session (replaces srand(time(0)))
+inline uint64_t timeSeed() {
+    return (uint64_t)std::time(0);
+}
+
+class RandomStream {
+public:
+    RandomStream() {
+        seed(0, 0);
+    }
+
+    RandomStream(uint64_t gameSeed, uint32_t streamId) {
+        seed(gameSeed, streamId);
+    }
+
+    void seed(uint64_t gameSeed, uint32_t streamId) {
+        uint64_t sm = gameSeed ^ ((uint64_t)streamId * 0xD1B54A32D192ED03ull);
+        uint64_t a = splitMix64(sm);
+        uint64_t b = splitMix64(sm);
+        s[0] = (uint32_t)a;
+        s[1] = (uint32_t)(a >> 32);
+        s[2] = (uint32_t)b;
+        s[3] = (uint32_t)(b >> 32);
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 1; // all-zero state is a fixed point
+    }
+
+    uint32_t next() {
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // Uniform in [0, n), a drop-in for rand() % n without the modulo bias
+    int range(int n) {
+        return (int)(((uint64_t)next() * (uint32_t)n) >> 32);
+    }
+
+    // Uniform in [0, 1)
+    float unit() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float range(float lo, float hi) {
+        return lo + (hi - lo) * unit();
+    }
+
+private:
+    uint32_t s[4];
+
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+};
+
+// ===== Stateless render jitter =====
+
+inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+inline uint32_t hashNoise(uint32_t id, uint32_t frame, uint32_t index) {
+    return hash32(id ^ hash32(frame ^ hash32(index + 0x9E3779B9u)));
+}
+
+// Uniform in [0, 1) for (id, frame, index)
+inline float hashUnit(uint32_t id, uint32_t frame, uint32_t index) {
+    return (hashNoise(id, frame, index) >> 8) * (1.0f / 16777216.0f);
+}
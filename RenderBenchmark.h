@@ -0,0 +1,255 @@
+#pragma once
+
+// Offscreen render benchmark.
+// Makes a windowless GL context through EGL's surfaceless platform, on
+// Mesa's software rasteriser by default, and renders an ArcadeGame's scene
+// into a framebuffer object for a fixed number of frames. Every frame runs
+// one simulation tick first, so a seeded game draws the same sequence each
+// run. Reports frames per second and per-frame wall and CPU time, and can
+// write a checksum of every frame's pixels so rendering changes show up as
+// a diff. Built with SPACESHIP_COUNT_ALLOCATIONS (see AllocationTracker.h),
+// it counts heap allocations per frame too. The first frame builds the
+// shared mesh, shader and glyph caches; every later one should make none,
+// and --zero-alloc fails the run when one does.
+//
+// libEGL is loaded at run time, so the programs don't link against it and
+// still start where it isn't installed.
+
+#include "AllocationTracker.h"
+#include "ArcadeGame.h"
+#include "CommandLine.h"
+#include "GLExtensions.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+// --benchmark [--seed S] [--frames N] [--warmup T] [--size WxH] [--checksums FILE] [--gpu] [--zero-alloc]
+struct BenchmarkOptions {
+    uint64_t seed = 1;       // fixed by default, unlike a normal game
+    long frames = 600;
+    long warmupTicks = 600;  // untimed ticks first, so the scene is fully populated
+    int width = 800;
+    int height = 600;
+    const char* checksumPath = nullptr;
+    bool software = true;    // --gpu takes whatever driver EGL picks instead
+    bool zeroAlloc = false;  // fail if any frame after the first allocates
+};
+
+inline BenchmarkOptions benchmarkOptions(int argc, char** argv) {
+    BenchmarkOptions options;
+    options.seed = argUint64(argc, argv, "--seed", options.seed);
+    options.frames = std::max(1L, argLong(argc, argv, "--frames", options.frames));
+    options.warmupTicks = std::max(0L, argLong(argc, argv, "--warmup", options.warmupTicks));
+    if (const char* size = argValue(argc, argv, "--size")) {
+        int width = 0, height = 0;
+        if (sscanf(size, "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+            options.width = width;
+            options.height = height;
+        }
+    }
+    options.checksumPath = argValue(argc, argv, "--checksums");
+    options.software = !hasArg(argc, argv, "--gpu");
+    options.zeroAlloc = hasArg(argc, argv, "--zero-alloc");
+    return options;
+}
+
+// Makes a windowless context current with a width x height framebuffer
+// object bound in place of a window. Returns false (after saying why) when
+// that isn't possible.
+inline bool createOffscreenContext(int width, int height, bool software) {
+#ifdef _WIN32
+    fprintf(stderr, "Offscreen rendering needs EGL, which Windows builds don't have\n");
+    return false;
+#else
+    typedef void* EGLDisplay;
+    typedef void* EGLContext;
+    typedef int32_t EGLint;
+    typedef unsigned EGLBoolean;
+    typedef EGLDisplay (*GetPlatformDisplayProc)(unsigned, void*, const EGLint*);
+    typedef EGLBoolean (*InitializeProc)(EGLDisplay, EGLint*, EGLint*);
+    typedef EGLBoolean (*BindAPIProc)(unsigned);
+    typedef EGLContext (*CreateContextProc)(EGLDisplay, void*, EGLContext, const EGLint*);
+    typedef EGLBoolean (*MakeCurrentProc)(EGLDisplay, void*, void*, EGLContext);
+    typedef void* (*GetProcAddressProc)(const char*);
+    const unsigned EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+    const unsigned EGL_OPENGL_API = 0x30A2;
+
+    // Must be set before the driver loads; an explicit setting wins
+    if (software) setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    void* egl = dlopen("libEGL.so.1", RTLD_NOW | RTLD_GLOBAL);
+    if (!egl) {
+        fprintf(stderr, "Offscreen rendering needs libEGL.so.1: %s\n", dlerror());
+        return false;
+    }
+    GetProcAddressProc getProcAddress = (GetProcAddressProc)dlsym(egl, "eglGetProcAddress");
+    InitializeProc initialize = (InitializeProc)dlsym(egl, "eglInitialize");
+    BindAPIProc bindAPI = (BindAPIProc)dlsym(egl, "eglBindAPI");
+    CreateContextProc createContext = (CreateContextProc)dlsym(egl, "eglCreateContext");
+    MakeCurrentProc makeCurrent = (MakeCurrentProc)dlsym(egl, "eglMakeCurrent");
+    GetPlatformDisplayProc getPlatformDisplay = nullptr;
+    if (getProcAddress) {
+        getPlatformDisplay = (GetPlatformDisplayProc)getProcAddress("eglGetPlatformDisplay");
+        if (!getPlatformDisplay) getPlatformDisplay = (GetPlatformDisplayProc)getProcAddress("eglGetPlatformDisplayEXT");
+    }
+    if (!initialize || !bindAPI || !createContext || !makeCurrent || !getPlatformDisplay) {
+        fprintf(stderr, "libEGL.so.1 is missing the entry points offscreen rendering needs\n");
+        return false;
+    }
+
+    // Surfaceless: no window system at all, and a context with no config
+    // (EGL_KHR_no_config_context) that only ever draws into FBOs
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+    EGLint major = 0, minor = 0;
+    if (!display || !initialize(display, &major, &minor) || !bindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "EGL has no surfaceless OpenGL display (Mesa's EGL_MESA_platform_surfaceless)\n");
+        return false;
+    }
+    EGLContext context = createContext(display, nullptr, nullptr, nullptr);
+    if (!context || !makeCurrent(display, nullptr, nullptr, context)) {
+        fprintf(stderr, "Could not make an offscreen OpenGL context current\n");
+        return false;
+    }
+
+    GLExtensions& ext = loadGLExtensions();
+    if (!ext.hasRenderbuffers()) {
+        fprintf(stderr, "The offscreen context has no framebuffer objects\n");
+        return false;
+    }
+    GLuint framebuffer = 0, renderbuffers[2] = {};
+    ext.GenFramebuffers(1, &framebuffer);
+    ext.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    ext.GenRenderbuffers(2, renderbuffers);
+    ext.BindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    ext.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    ext.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    ext.BindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    ext.RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    ext.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    if (ext.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Could not set up a %dx%d offscreen framebuffer\n", width, height);
+        return false;
+    }
+    // Windowed programs draw to the back buffer; here that's the FBO's attachment
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glViewport(0, 0, width, height);
+    return true;
+#endif
+}
+
+// Renders `game` offscreen as described at the top of this file. `script`,
+// if given, runs before every tick to queue that tick's input. Fonts only
+// appear when a display is available for glutInit.
+inline int runRenderBenchmark(int argc, char** argv, ArcadeGame& game, void (*script)() = nullptr) {
+    BenchmarkOptions options = benchmarkOptions(argc, argv);
+#ifndef _WIN32
+    if (getenv("DISPLAY")) glutInit(&argc, argv);
+#endif
+    if (options.zeroAlloc && !heapAllocationsCounted()) {
+        fprintf(stderr, "--zero-alloc needs a build with -DSPACESHIP_COUNT_ALLOCATIONS\n");
+        return 1;
+    }
+    if (!createOffscreenContext(options.width, options.height, options.software)) return 1;
+
+    FILE* checksums = nullptr;
+    if (options.checksumPath) {
+        checksums = fopen(options.checksumPath, "w");
+        if (!checksums) {
+            fprintf(stderr, "Could not write checksums to %s\n", options.checksumPath);
+            return 1;
+        }
+    }
+
+    const float deltaTime = 1.0f / 60.0f;
+    game.init(options.seed);
+    game.reshape(options.width, options.height);
+    for (long tick = 0; tick < options.warmupTicks; tick++) {
+        if (script) script();
+        game.update(deltaTime);
+    }
+
+    std::vector<double> wallTimes, cpuTimes;
+    std::vector<unsigned char> pixels;
+    wallTimes.reserve(options.frames);
+    cpuTimes.reserve(options.frames);
+    if (checksums) pixels.resize((size_t)options.width * options.height * 4);
+    uint64_t firstFrameAllocations = 0, laterAllocations = 0, peakAllocations = 0;
+    long allocatingFrames = 0;
+    auto benchmarkStart = std::chrono::steady_clock::now();
+    double readbackSeconds = 0.0;
+    for (long frame = 0; frame < options.frames; frame++) {
+        uint64_t allocationsBefore = heapAllocations();
+        profiler().beginFrame();
+        if (script) script();
+        game.update(deltaTime);
+
+        // Timed from the first GL call to the last pixel written
+        auto start = std::chrono::steady_clock::now();
+        clock_t cpuStart = clock();
+        game.render(1.0f, (options.warmupTicks + frame) * deltaTime);
+        glFinish();
+        cpuTimes.push_back((double)(clock() - cpuStart) / CLOCKS_PER_SEC);
+        wallTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        uint64_t allocations = heapAllocations() - allocationsBefore;
+        if (frame == 0) {
+            firstFrameAllocations = allocations;
+        }
+        else {
+            laterAllocations += allocations;
+            peakAllocations = std::max(peakAllocations, allocations);
+            if (allocations > 0) allocatingFrames++;
+        }
+
+        if (checksums) {
+            auto readStart = std::chrono::steady_clock::now();
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, options.width, options.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            StateHash hash;
+            hash.add(pixels.data(), pixels.size());
+            fprintf(checksums, "%ld %016llx\n", frame, (unsigned long long)hash.value());
+            readbackSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - readStart).count();
+        }
+    }
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - benchmarkStart).count() - readbackSeconds;
+    game.shutdown();
+    if (checksums) fclose(checksums);
+
+    double cpuTotal = 0.0;
+    for (double seconds : cpuTimes) cpuTotal += seconds;
+    std::vector<double> sorted = wallTimes;
+    std::sort(sorted.begin(), sorted.end());
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    printf("%s render benchmark: %ld frames at %dx%d, seed %llu\n", game.title(), options.frames,
+        options.width, options.height, (unsigned long long)options.seed);
+    printf("  renderer: %s\n", renderer ? renderer : "unknown");
+    printf("  frames/second: %.1f\n", totalSeconds > 0.0 ? options.frames / totalSeconds : 0.0);
+    printf("  frame ms: p50 %.3f, p99 %.3f, first %.3f\n", sorted[sorted.size() / 2] * 1000.0,
+        sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)] * 1000.0, wallTimes[0] * 1000.0);
+    printf("  CPU ms/frame: %.3f (all threads, including the rasteriser's)\n", cpuTotal / options.frames * 1000.0);
+    if (!heapAllocationsCounted()) {
+        printf("  heap allocations: not counted in this build\n");
+    }
+    else if (allocatingFrames == 0) {
+        printf("  heap allocations: %llu in the first frame, then none\n", (unsigned long long)firstFrameAllocations);
+    }
+    else {
+        printf("  heap allocations: %llu in the first frame, then %llu across %ld frames (at most %llu in one)\n",
+            (unsigned long long)firstFrameAllocations, (unsigned long long)laterAllocations, allocatingFrames,
+            (unsigned long long)peakAllocations);
+    }
+    if (options.checksumPath) printf("  frame checksums written to %s\n", options.checksumPath);
+    if (options.zeroAlloc && allocatingFrames > 0) {
+        fprintf(stderr, "--zero-alloc: %ld frames allocated on the heap\n", allocatingFrames);
+        return 1;
+    }
+    return 0;
+}
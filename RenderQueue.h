@@ -0,0 +1,149 @@
+#pragma once
+
+// Sorted scene submission.
+// Draw functions queue their meshes and batches during render() instead of
+// drawing them straight away; flush() then draws the opaque pass front to
+// back, so hidden fragments fail the depth test early, followed by the
+// blended pass back to front, so translucent surfaces composite correctly.
+// Blend state is only touched where consecutive items need different modes.
+//
+// Sort key, high bit first: pass (1), eye depth (32, inverted for the
+// blended pass), blend mode (2), submission order (29). Depth is the float's
+// bit pattern, which orders the same as the value for non-negative floats.
+
+#include "MeshCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum BlendMode { BLEND_OPAQUE, BLEND_ALPHA, BLEND_ADDITIVE };
+
+class RenderQueue {
+public:
+    // Draws a self-contained batch (instanced meshes, particles, glows). It
+    // runs with the modelview it was queued under, lighting on and blending
+    // off, and must leave that state behind, as the batch classes do.
+    typedef void (*DrawBatch)();
+
+    // Starts a frame's submission; the current modelview is the camera
+    void begin() {
+        items.clear();
+        camera = LodView::current();
+    }
+
+    // Eye-space depth of a world-space point, for placing batches
+    float eyeDepth(float x, float y, float z) const {
+        const float* m = camera.modelview;
+        return -(m[2] * x + m[6] * y + m[10] * z + m[14]);
+    }
+
+    // A mesh at the current modelview, tinted with glColor
+    void add(const Mesh& mesh, const float color[4], BlendMode blend = BLEND_OPAQUE) {
+        Item& item = push(blend);
+        glGetFloatv(GL_MODELVIEW_MATRIX, item.matrix);
+        item.mesh = &mesh;
+        memcpy(item.color, color, sizeof(item.color));
+        item.key = makeKey(blend, -item.matrix[14], items.size() - 1);
+    }
+
+    // The same, at the LOD level for the mesh's size on screen
+    void add(const LodMesh& lod, const float color[4], BlendMode blend = BLEND_OPAQUE) {
+        add(lod.level(0), color, blend);
+        LodView view = camera;
+        memcpy(view.modelview, items.back().matrix, sizeof(view.modelview));
+        items.back().mesh = &lod.level(lod.levelFor(view.pixelRadius(0.0f, 0.0f, 0.0f, lod.radius)));
+    }
+
+    void addBatch(DrawBatch draw, float depth, BlendMode blend) {
+        Item& item = push(blend);
+        memcpy(item.matrix, camera.modelview, sizeof(item.matrix));
+        item.batch = draw;
+        item.key = makeKey(blend, depth, items.size() - 1);
+    }
+
+    // Draws everything queued since begin() in key order
+    void flush() {
+        order.resize(items.size());
+        for (size_t i = 0; i < items.size(); i++) order[i] = { items[i].key, (uint32_t)i };
+        std::sort(order.begin(), order.end(), [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+
+        glPushMatrix();
+        glDisable(GL_BLEND);
+        glEnable(GL_LIGHTING);
+        BlendMode current = BLEND_OPAQUE;
+        for (const SortEntry& entry : order) {
+            const Item& item = items[entry.index];
+            BlendMode wanted = item.batch ? BLEND_OPAQUE : item.blend;
+            if (wanted != current) {
+                setBlend(wanted);
+                current = wanted;
+            }
+            glLoadMatrixf(item.matrix);
+            if (item.batch) {
+                item.batch();
+            }
+            else {
+                glColor4fv(item.color);
+                item.mesh->draw();
+            }
+        }
+        if (current != BLEND_OPAQUE) setBlend(BLEND_OPAQUE);
+        glPopMatrix();
+        items.clear();
+    }
+
+private:
+    static const uint64_t ORDER_BITS = 29;
+
+    struct Item {
+        uint64_t key;
+        float matrix[16];
+        float color[4];
+        const Mesh* mesh;
+        DrawBatch batch;
+        BlendMode blend;
+    };
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<Item> items; // capacity is kept across frames
+    std::vector<SortEntry> order;
+    LodView camera;
+
+    Item& push(BlendMode blend) {
+        items.push_back(Item());
+        Item& item = items.back();
+        item.mesh = nullptr;
+        item.batch = nullptr;
+        item.blend = blend;
+        return item;
+    }
+
+    static uint64_t makeKey(BlendMode blend, float depth, size_t order) {
+        uint32_t depthBits;
+        depth = std::max(depth, 0.0f);
+        memcpy(&depthBits, &depth, sizeof(depthBits));
+        bool blended = blend != BLEND_OPAQUE;
+        if (blended) depthBits = ~depthBits;
+        return (uint64_t)blended << 63 | (uint64_t)depthBits << 31 | (uint64_t)blend << ORDER_BITS
+            | (order & ((1u << ORDER_BITS) - 1));
+    }
+
+    static void setBlend(BlendMode blend) {
+        if (blend == BLEND_OPAQUE) {
+            glDisable(GL_BLEND);
+            return;
+        }
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, blend == BLEND_ADDITIVE ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+    }
+};
+
+inline RenderQueue& renderQueue() {
+    static RenderQueue queue;
+    return queue;
+}
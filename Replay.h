@@ -0,0 +1,357 @@
+#pragma once
+
+// Input recording and replay.
+// Games route every simulation input through InputReplay, which applies it
+// at the start of the next fixed tick, so a run is fully determined by its
+// seed, settings and tick-stamped input stream. Recording writes that stream
+// to a compact binary file and playback feeds it back tick for tick.
+//
+// File layout: "SSRP", then varints for the format version, game name
+// (length + bytes), seed, hash interval and the game's settings (count +
+// values). Records follow, each a varint of (ticks since the previous
+// record << 2 | kind) and a payload: the key code << 1 | released for key
+// and special-key records, the low 32 bits of the running state hash for
+// checkpoints, and nothing for the end marker. A checkpoint is written
+// every HASH_INTERVAL ticks, so playback catches a divergence within that
+// many ticks.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// FNV-1a over the simulation state; chained across ticks, so a checkpoint
+// covers every tick before it
+class StateHash {
+public:
+    void add(const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+
+    template <typename T>
+    void add(const T& value) {
+        add(&value, sizeof(value));
+    }
+
+    uint64_t value() const {
+        return hash;
+    }
+
+    void reset() {
+        hash = 14695981039346656037ULL;
+    }
+
+private:
+    uint64_t hash = 14695981039346656037ULL;
+};
+
+struct ReplayHeader {
+    std::string game;
+    uint64_t seed = 0;
+    std::vector<uint32_t> settings; // game-specific; floats are stored as their bits
+};
+
+inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+class InputReplay {
+public:
+    static const uint64_t HASH_INTERVAL = 60; // one checkpoint per simulated second
+    static const uint64_t VERSION = 2; // 2 added key releases
+
+    typedef void (*ApplyInput)(bool special, int key, bool pressed);
+    typedef void (*HashState)(StateHash& hash);
+
+    // `apply` performs one input on the simulation; `hashState` adds
+    // everything the simulation depends on to the hash
+    InputReplay(ApplyInput apply, HashState hashState) : apply(apply), hashState(hashState) {
+    }
+
+    bool recording() const {
+        return mode == RECORDING;
+    }
+
+    bool playing() const {
+        return mode == PLAYBACK;
+    }
+
+    // Ticks run since recording or playback started
+    uint64_t tick() const {
+        return currentTick;
+    }
+
+    // Checkpoint tick where playback first disagreed with the file, or 0
+    uint64_t divergedAt() const {
+        return divergedTick;
+    }
+
+    uint64_t checkpointsVerified() const {
+        return verified;
+    }
+
+    // Input from the GLUT callbacks or a scripted player, applied at the
+    // next tick: a key going down or, with `pressed` false, coming up. Live
+    // input is ignored while a replay is playing.
+    void queue(bool special, int key, bool pressed = true) {
+        if (mode == PLAYBACK) return;
+        Input input = { special, key, pressed };
+        pending.push_back(input);
+    }
+
+    // Call before the simulation is seeded and reset, so the first recorded
+    // tick starts from the state the header describes
+    bool startRecording(const char* path, const ReplayHeader& header) {
+        file = fopen(path, "wb");
+        if (!file) {
+            fprintf(stderr, "Could not record replay to %s\n", path);
+            return false;
+        }
+        buffer.assign({ 'S', 'S', 'R', 'P' });
+        writeVarint(VERSION);
+        writeVarint(header.game.size());
+        buffer.insert(buffer.end(), header.game.begin(), header.game.end());
+        writeVarint(header.seed);
+        writeVarint(HASH_INTERVAL);
+        writeVarint(header.settings.size());
+        for (uint32_t setting : header.settings) writeVarint(setting);
+        flush();
+
+        mode = RECORDING;
+        begin();
+        return true;
+    }
+
+    // Loads a whole replay of `game` and fills in its header. Returns false
+    // (after saying why) if the file is missing, malformed or for another game.
+    bool startPlayback(const char* path, const char* game, ReplayHeader& header) {
+        FILE* in = fopen(path, "rb");
+        if (!in) {
+            fprintf(stderr, "Could not open replay %s\n", path);
+            return false;
+        }
+        std::vector<unsigned char> data;
+        unsigned char chunk[4096];
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), in)) > 0) data.insert(data.end(), chunk, chunk + got);
+        fclose(in);
+
+        const unsigned char* p = data.data();
+        const unsigned char* end = p + data.size();
+        uint64_t version = 0, nameLength = 0, interval = 0, settingCount = 0;
+        bool ok = data.size() >= 4 && memcmp(p, "SSRP", 4) == 0;
+        if (ok) p += 4;
+        ok = ok && readVarint(p, end, version) && version == VERSION;
+        ok = ok && readVarint(p, end, nameLength) && nameLength <= (uint64_t)(end - p);
+        if (ok) {
+            header.game.assign((const char*)p, (size_t)nameLength);
+            p += nameLength;
+        }
+        ok = ok && readVarint(p, end, header.seed) && readVarint(p, end, interval) && interval == HASH_INTERVAL;
+        ok = ok && readVarint(p, end, settingCount) && settingCount <= (uint64_t)(end - p);
+        header.settings.clear();
+        for (uint64_t i = 0; ok && i < settingCount; i++) {
+            uint64_t setting = 0;
+            ok = readVarint(p, end, setting);
+            header.settings.push_back((uint32_t)setting);
+        }
+        if (!ok) {
+            fprintf(stderr, "%s is not a replay file this version can read\n", path);
+            return false;
+        }
+        if (header.game != game) {
+            fprintf(stderr, "%s is a %s replay, not %s\n", path, header.game.c_str(), game);
+            return false;
+        }
+
+        // A recording cut short by a crash simply ends at its last whole record
+        records.clear();
+        uint64_t recordTick = 0;
+        while (p < end) {
+            uint64_t tag = 0, payload = 0;
+            if (!readVarint(p, end, tag)) break;
+            Record record;
+            record.kind = (Kind)(tag & 3);
+            record.tick = recordTick += tag >> 2;
+            if (record.kind == HASH) {
+                if (end - p < 4) break;
+                payload = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint64_t)p[3] << 24);
+                p += 4;
+            }
+            else if (record.kind != END && !readVarint(p, end, payload)) {
+                break;
+            }
+            record.value = (uint32_t)payload;
+            records.push_back(record);
+            if (record.kind == END) break;
+        }
+
+        mode = PLAYBACK;
+        cursor = 0;
+        divergedTick = 0;
+        verified = 0;
+        begin();
+        return true;
+    }
+
+    // Playback has consumed the whole file
+    bool finished() const {
+        if (mode != PLAYBACK) return false;
+        return cursor == records.size() || (records[cursor].kind == END && currentTick >= records[cursor].tick);
+    }
+
+    // Applies this tick's input: queued live input, or the file's during playback
+    void beginTick() {
+        if (mode == PLAYBACK) {
+            while (cursor < records.size() && records[cursor].tick == currentTick
+                && (records[cursor].kind == KEY || records[cursor].kind == SPECIAL_KEY)) {
+                uint32_t value = records[cursor].value;
+                apply(records[cursor].kind == SPECIAL_KEY, (int)(value >> 1), !(value & 1));
+                cursor++;
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < pending.size(); i++) {
+            const Input& input = pending[i];
+            if (mode == RECORDING) writeRecord(input.special ? SPECIAL_KEY : KEY, (uint32_t)input.key << 1 | !input.pressed);
+            apply(input.special, input.key, input.pressed);
+        }
+        pending.clear();
+    }
+
+    // Hashes the state the tick left behind and writes or checks a checkpoint
+    void endTick() {
+        if (mode == LIVE) return;
+        hashState(hash);
+        currentTick++;
+        if (currentTick % HASH_INTERVAL != 0) return;
+
+        uint32_t checkpoint = (uint32_t)hash.value();
+        if (mode == RECORDING) {
+            writeRecord(HASH, checkpoint);
+            flush(); // a crash loses at most the last second
+        }
+        else if (cursor < records.size() && records[cursor].kind == HASH && records[cursor].tick == currentTick) {
+            if (records[cursor].value == checkpoint) verified++;
+            else if (divergedTick == 0) divergedTick = currentTick;
+            cursor++;
+        }
+    }
+
+    // Ends a recording with its length and closes the file
+    void stopRecording() {
+        if (mode != RECORDING) return;
+        writeRecord(END, 0);
+        flush();
+        fclose(file);
+        file = nullptr;
+        mode = LIVE;
+    }
+
+    // Prints whether playback matched the recording; returns true if it did
+    bool reportPlayback(const char* path) const {
+        if (divergedTick) {
+            printf("Replay %s diverged from the recording between ticks %llu and %llu\n", path,
+                (unsigned long long)(divergedTick - HASH_INTERVAL), (unsigned long long)divergedTick);
+            return false;
+        }
+        printf("Replay %s matched the recording: %llu ticks, %llu checkpoints\n", path,
+            (unsigned long long)currentTick, (unsigned long long)verified);
+        return true;
+    }
+
+    // Hands control back to live input once a replay has finished
+    void stopPlayback() {
+        mode = LIVE;
+        records.clear();
+        cursor = 0;
+    }
+
+private:
+    enum Mode { LIVE, RECORDING, PLAYBACK };
+    enum Kind { KEY, SPECIAL_KEY, HASH, END };
+
+    struct Input {
+        bool special;
+        int key;
+        bool pressed;
+    };
+
+    struct Record {
+        uint64_t tick;
+        Kind kind;
+        uint32_t value;
+    };
+
+    ApplyInput apply;
+    HashState hashState;
+    Mode mode = LIVE;
+    std::vector<Input> pending;
+    uint64_t currentTick = 0;
+    StateHash hash;
+
+    FILE* file = nullptr;
+    std::vector<unsigned char> buffer; // encoded records not yet written
+    uint64_t lastRecordTick = 0;
+
+    std::vector<Record> records;
+    size_t cursor = 0;
+    uint64_t divergedTick = 0;
+    uint64_t verified = 0;
+
+    void begin() {
+        pending.clear();
+        currentTick = 0;
+        lastRecordTick = 0;
+        hash.reset();
+    }
+
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((unsigned char)value);
+    }
+
+    static bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            unsigned char byte = *p++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    void writeRecord(Kind kind, uint32_t value) {
+        writeVarint((currentTick - lastRecordTick) << 2 | kind);
+        lastRecordTick = currentTick;
+        if (kind == HASH) {
+            for (int i = 0; i < 4; i++) buffer.push_back((unsigned char)(value >> (8 * i)));
+        }
+        else if (kind != END) {
+            writeVarint(value);
+        }
+    }
+
+    void flush() {
+        if (!file || buffer.empty()) return;
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        fflush(file);
+        buffer.clear();
+    }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+// Fixed-capacity FIFO stored in place.
+// Items are pushed at the back and popped from either end without moving
+// the others or touching the heap; the head index just wraps around the array.
+
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static const size_t CAPACITY = Capacity;
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    bool full() const {
+        return count == Capacity;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Returns false, leaving the buffer unchanged, when it is full
+    bool push_back(const T& item) {
+        if (full()) return false;
+        items[(head + count) & (Capacity - 1)] = item;
+        count++;
+        return true;
+    }
+
+    void pop_front() {
+        if (empty()) return;
+        head = (head + 1) & (Capacity - 1);
+        count--;
+    }
+
+    void pop_back() {
+        if (empty()) return;
+        count--;
+    }
+
+    // i-th item from the front
+    T& operator[](size_t i) {
+        return items[(head + i) & (Capacity - 1)];
+    }
+
+    const T& operator[](size_t i) const {
+        return items[(head + i) & (Capacity - 1)];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[count - 1];
+    }
+
+private:
+    T items[Capacity];
+    size_t head = 0;
+    size_t count = 0;
+};
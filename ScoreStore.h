@@ -0,0 +1,288 @@
+#pragma once
+
+// Shared high-score file.
+// Keeps the best TOP_N scores of every game in one binary file. All file
+// access happens on a background thread, so opening the store never delays
+// startup and recording a score on the game-over path never waits on
+// storage. Submitted scores are visible straight away; the file catches up
+// shortly after. Each save writes a temporary file, flushes it to disk and
+// renames it over the old one, so a crash or power cut leaves either the
+// old leaderboard or the new one, never a torn file.
+//
+// File layout (little-endian): "SSHS", u32 format version, u32 game count,
+// then per game a u16 name length, the name, a u16 entry count and that many
+// (i32 score, i64 unix time) pairs, best first. A u32 FNV-1a of everything
+// before it ends the file; a file that fails it is ignored.
+
+#include "Replay.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Shared by every game, so the arcade keeps one leaderboard file
+const char* const SCORE_FILE = "scores.dat";
+
+struct ScoreEntry {
+    int32_t score;
+    int64_t time; // when it was set, seconds since the Unix epoch
+};
+
+class ScoreStore {
+public:
+    static const int TOP_N = 10;
+    static const uint32_t VERSION = 1;
+
+    // Reads a game's score from before the shared file existed, or returns 0
+    typedef int (*LegacyReader)();
+
+    ~ScoreStore() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!worker.joinable()) return;
+        stopping = true;
+        wake.notify_one();
+        lock.unlock();
+        worker.join(); // finishes any pending save first
+    }
+
+    // Starts loading `path` in the background; later calls only add their
+    // `legacy` reader, which runs once if the file has no board for `game`
+    void open(const char* path, const char* game = nullptr, LegacyReader legacy = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (game && legacy) imports.push_back({ game, legacy });
+        if (worker.joinable()) {
+            wake.notify_one();
+            return;
+        }
+        filePath = path;
+        worker = std::thread([this] { run(); });
+    }
+
+    // True once the file has been read (or found missing)
+    bool loaded() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fileLoaded;
+    }
+
+    // Changes whenever any leaderboard does, so displays can skip rebuilding
+    uint64_t revision() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return changes;
+    }
+
+    // Records a finished game; returns its 1-based rank, or 0 if it didn't place
+    int submit(const char* game, int score) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int rank = insert(boards[game], { score, (int64_t)::time(nullptr) });
+        if (rank) {
+            changes++;
+            dirty = true;
+            wake.notify_one();
+        }
+        return rank;
+    }
+
+    int best(const char* game) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto board = boards.find(game);
+        return board == boards.end() || board->second.empty() ? 0 : board->second[0].score;
+    }
+
+    std::vector<ScoreEntry> leaderboard(const char* game) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto board = boards.find(game);
+        return board == boards.end() ? std::vector<ScoreEntry>() : board->second;
+    }
+
+private:
+    // std::less<> looks boards up by const char* without building a string
+    typedef std::map<std::string, std::vector<ScoreEntry>, std::less<>> Boards;
+
+    struct LegacyImport {
+        std::string game;
+        LegacyReader read;
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+    std::string filePath;
+    Boards boards;
+    std::set<std::string> savedGames; // have a board in the file
+    std::vector<LegacyImport> imports;
+    bool fileLoaded = false;
+    bool dirty = false;     // changed since the last save
+    uint64_t changes = 0;
+    bool stopping = false;
+
+    // Keeps the board sorted best first and at most TOP_N long
+    static int insert(std::vector<ScoreEntry>& board, const ScoreEntry& entry) {
+        if (entry.score <= 0) return 0;
+        auto at = std::upper_bound(board.begin(), board.end(), entry,
+            [](const ScoreEntry& a, const ScoreEntry& b) { return a.score > b.score; });
+        if (at - board.begin() >= TOP_N) return 0;
+        int rank = (int)(at - board.begin()) + 1;
+        board.insert(at, entry);
+        if ((int)board.size() > TOP_N) board.pop_back();
+        return rank;
+    }
+
+    void run() {
+        Boards stored;
+        bool readable = read(filePath, stored);
+        std::unique_lock<std::mutex> lock(mutex);
+        // Scores submitted while the file was loading join the stored ones
+        for (auto& board : stored) {
+            for (const ScoreEntry& entry : board.second) insert(boards[board.first], entry);
+            savedGames.insert(board.first);
+        }
+        fileLoaded = true;
+        changes++;
+        if (!readable) {
+            // Kept aside rather than overwritten by the next save
+            std::string aside = filePath + ".bad";
+            remove(aside.c_str());
+            rename(filePath.c_str(), aside.c_str());
+            fprintf(stderr, "%s is not a score file this version can read; moved it to %s\n", filePath.c_str(), aside.c_str());
+        }
+
+        while (true) {
+            wake.wait(lock, [this] { return stopping || dirty || !imports.empty(); });
+            if (!imports.empty()) {
+                std::vector<LegacyImport> pending;
+                pending.swap(imports);
+                for (const LegacyImport& import : pending) {
+                    if (!savedGames.insert(import.game).second) continue;
+                    lock.unlock();
+                    int score = import.read();
+                    lock.lock();
+                    if (insert(boards[import.game], { score, (int64_t)::time(nullptr) })) {
+                        changes++;
+                        dirty = true;
+                    }
+                }
+            }
+            if (dirty) {
+                Boards snapshot = boards;
+                dirty = false;
+                lock.unlock();
+                write(filePath, snapshot);
+                lock.lock();
+            }
+            if (stopping && !dirty && imports.empty()) return;
+        }
+    }
+
+    static void put(std::vector<unsigned char>& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) out.push_back((unsigned char)(value >> (8 * i)));
+    }
+
+    static bool get(const unsigned char*& p, const unsigned char* end, uint64_t& value, int bytes) {
+        if (end - p < bytes) return false;
+        value = 0;
+        for (int i = 0; i < bytes; i++) value |= (uint64_t)*p++ << (8 * i);
+        return true;
+    }
+
+    static uint32_t checksum(const unsigned char* data, size_t size) {
+        StateHash hash;
+        hash.add(data, size);
+        return (uint32_t)hash.value();
+    }
+
+    // Missing files read as empty; returns false if the file exists but is unusable
+    static bool read(const std::string& path, Boards& boards) {
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in) return true;
+        std::vector<unsigned char> data;
+        unsigned char chunk[4096];
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), in)) > 0) data.insert(data.end(), chunk, chunk + got);
+        fclose(in);
+
+        if (data.size() < 16 || memcmp(data.data(), "SSHS", 4) != 0) return false;
+        const unsigned char* p = data.data() + 4;
+        const unsigned char* end = data.data() + data.size() - 4;
+        const unsigned char* tail = end;
+        uint64_t stored = 0, version = 0, gameCount = 0;
+        get(tail, tail + 4, stored, 4);
+        if (stored != checksum(data.data(), data.size() - 4)) return false;
+        if (!get(p, end, version, 4) || version != VERSION || !get(p, end, gameCount, 4)) return false;
+
+        Boards parsed; // only kept if the whole file reads
+        for (uint64_t g = 0; g < gameCount; g++) {
+            uint64_t nameLength = 0, entryCount = 0;
+            if (!get(p, end, nameLength, 2) || (uint64_t)(end - p) < nameLength) return false;
+            std::string name((const char*)p, (size_t)nameLength);
+            p += nameLength;
+            if (!get(p, end, entryCount, 2)) return false;
+            std::vector<ScoreEntry>& board = parsed[name];
+            for (uint64_t i = 0; i < entryCount; i++) {
+                uint64_t score = 0, time = 0;
+                if (!get(p, end, score, 4) || !get(p, end, time, 8)) return false;
+                insert(board, { (int32_t)(uint32_t)score, (int64_t)time });
+            }
+        }
+        boards.swap(parsed);
+        return true;
+    }
+
+    static void write(const std::string& path, const Boards& boards) {
+        std::vector<unsigned char> data = { 'S', 'S', 'H', 'S' };
+        put(data, VERSION, 4);
+        put(data, boards.size(), 4);
+        for (const auto& board : boards) {
+            put(data, board.first.size(), 2);
+            data.insert(data.end(), board.first.begin(), board.first.end());
+            put(data, board.second.size(), 2);
+            for (const ScoreEntry& entry : board.second) {
+                put(data, (uint32_t)entry.score, 4);
+                put(data, (uint64_t)entry.time, 8);
+            }
+        }
+        put(data, checksum(data.data(), data.size()), 4);
+
+        std::string temp = path + ".tmp";
+        FILE* out = fopen(temp.c_str(), "wb");
+        if (!out) {
+            fprintf(stderr, "Could not save scores to %s\n", temp.c_str());
+            return;
+        }
+        bool ok = fwrite(data.data(), 1, data.size(), out) == data.size() && fflush(out) == 0;
+#ifndef _WIN32
+        ok = ok && fsync(fileno(out)) == 0; // on disk before it replaces the old file
+#endif
+        ok = fclose(out) == 0 && ok;
+#ifdef _WIN32
+        ok = ok && MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        ok = ok && rename(temp.c_str(), path.c_str()) == 0;
+#endif
+        if (!ok) {
+            fprintf(stderr, "Could not save scores to %s\n", path.c_str());
+            remove(temp.c_str());
+        }
+    }
+};
+
+inline ScoreStore& scoreStore() {
+    static ScoreStore store;
+    return store;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+// Simulation thread.
+// Runs a game's fixed ticks on a thread of their own, so a slow frame on the
+// GLUT thread no longer holds up gameplay and a burst of catch-up ticks no
+// longer holds up a frame. After each batch of ticks the game copies what
+// render() reads into a snapshot and publishes it through a SnapshotBuffer;
+// the render thread picks up the newest complete snapshot without locking or
+// waiting. Key presses go the other way through an SpscQueue and are applied
+// at the start of the next tick, as they always were.
+
+#include "FrameClock.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+// A key press on its way from the GLUT callbacks to the simulation
+struct KeyInput {
+    bool special;
+    int key;
+};
+
+// FIFO between exactly one producer thread and one consumer thread; neither
+// side ever blocks
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer only; returns false, dropping the item, when the queue is full
+    bool push(const T& item) {
+        size_t tail = writeIndex.load(std::memory_order_relaxed);
+        if (tail - readIndex.load(std::memory_order_acquire) == Capacity) return false;
+        items[tail & (Capacity - 1)] = item;
+        writeIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; returns false when there is nothing to take
+    bool pop(T& item) {
+        size_t head = readIndex.load(std::memory_order_relaxed);
+        if (head == writeIndex.load(std::memory_order_acquire)) return false;
+        item = items[head & (Capacity - 1)];
+        readIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    // On separate cache lines, so the two threads don't contend for one
+    alignas(64) std::atomic<size_t> writeIndex{ 0 };
+    alignas(64) std::atomic<size_t> readIndex{ 0 };
+};
+
+// Hands the latest snapshot from one writer thread to one reader thread.
+// The writer fills back() and publishes it; acquire() gives the reader the
+// newest published snapshot, which nothing touches until its next acquire().
+// A third slot lets the writer fill the next snapshot while the reader still
+// holds one and another waits published, so neither side ever waits.
+template <typename T>
+class SnapshotBuffer {
+public:
+    // Calls visit(slot) on all three slots, e.g. to reserve room in them;
+    // only while neither the writer nor the reader is running
+    template <typename Visit>
+    void forEachSlot(const Visit& visit) {
+        for (T& slot : slots) visit(slot);
+    }
+
+    // Writer only: the snapshot to fill before publish()
+    T& back() {
+        return slots[writing];
+    }
+
+    void publish() {
+        writing = latest.exchange(writing | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader only: swaps in the newest snapshot if one was published since
+    // the last call. Before any publish() it is a default-constructed T.
+    const T& acquire() {
+        if (latest.load(std::memory_order_relaxed) & FRESH) {
+            reading = latest.exchange(reading, std::memory_order_acq_rel) & INDEX;
+        }
+        return slots[reading];
+    }
+
+private:
+    static const unsigned INDEX = 3; // slot number in `latest`
+    static const unsigned FRESH = 4; // set by publish(), cleared by acquire()
+
+    T slots[3];
+    unsigned writing = 0;
+    std::atomic<unsigned> latest{ 1 };
+    unsigned reading = 2;
+};
+
+class SimulationThread {
+public:
+    typedef void (*Tick)(float deltaTime);
+    typedef void (*Publish)();
+
+    ~SimulationThread() {
+        stop();
+    }
+
+    // Calls `tick` every `tickSeconds` on a new thread, and `publish` after
+    // each batch of ticks. Like FrameClock, it drops time rather than run
+    // more than MAX_TICKS_PER_FRAME ticks to catch up.
+    void start(float tickSeconds, Tick tick, Publish publish) {
+        if (thread.joinable()) return;
+        this->tickSeconds = tickSeconds;
+        this->tick = tick;
+        this->publish = publish;
+        stopping = false;
+        stateTime = 0.0;
+        epoch = Clock::now();
+        profiler(); // made before the thread first uses it, so it outlives the thread at exit
+        thread = std::thread([this] { run(); });
+    }
+
+    // Returns once the tick in progress, if any, has finished
+    void stop() {
+        if (!thread.joinable()) return;
+        stopping = true;
+        thread.join();
+    }
+
+    bool running() const {
+        return thread.joinable();
+    }
+
+    // Simulation thread only: seconds on this thread's clock at which the
+    // state the last tick left behind is current, for stamping snapshots
+    double tickTime() const {
+        return stateTime;
+    }
+
+    // Render thread: how far (0..1) real time has run past a snapshot
+    // stamped with tickTime() `time`
+    float alpha(double time) const {
+        double ticksAhead = (std::chrono::duration<double>(Clock::now() - epoch).count() - time) / tickSeconds;
+        return (float)std::min(1.0, std::max(0.0, ticksAhead));
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    std::thread thread;
+    std::atomic<bool> stopping{ false };
+    float tickSeconds = 1.0f / 60.0f;
+    Tick tick = nullptr;
+    Publish publish = nullptr;
+    Clock::time_point epoch;
+    double stateTime = 0.0;
+
+    void run() {
+        profiler().nameThread("Simulation");
+        Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickSeconds));
+        Clock::time_point due = epoch + period; // when the next tick's state becomes current
+        while (!stopping.load(std::memory_order_relaxed)) {
+            Clock::time_point now = Clock::now();
+            if (due <= now) {
+                {
+                    ProfileZone zone("update");
+                    for (int ticks = 0; due <= now && ticks < FrameClock::MAX_TICKS_PER_FRAME; ticks++) {
+                        tick(tickSeconds);
+                        due += period;
+                    }
+                }
+                if (due <= now) due = now + period; // fell behind; don't try to catch up with a burst
+                stateTime = std::chrono::duration<double>(due - period - epoch).count();
+                ProfileZone zone("publish");
+                publish();
+            }
+            std::this_thread::sleep_until(due);
+        }
+    }
+};
@@ -1,17 +1,26 @@
 #include <GL/glut.h>
 #include <cstdlib>
-#include <ctime>
+#include "CommandLine.h"
+#include "FrameClock.h"
+#include "Random.h"
+#include "Starfield.h"
+#include "TextRenderer.h"
 
-const int NUM_STARS = 1000;
-float movementSpeed = 0.1f;
+// Both games are compiled into the menu and run as scenes in its window
+#define SPACESHIP_ARCADE_HOST
+#include "Flappy Spaceship.cpp"
+#include "Spaceship Defender.cpp"
 
-struct Star {
-    float x, y, z;
-    float brightness;
-    float speed;
-};
+const int NUM_STARS = 1000;
+int numStars = NUM_STARS; // --stars N for a denser backdrop
+float movementSpeed = 6.0f; // units per second
+FrameClock frameClock;
 
-Star stars[NUM_STARS];
+Starfield starfield;
+uint64_t gameSeed = timeSeed(); // --seed S
+bool fixedSeed = false;         // with --seed every game replays the same course
+bool simulationThreads = true;  // games tick on threads of their own, unless --no-sim-thread
+RandomStream starRng;
 
 enum AppState {
     MENU,
@@ -20,130 +29,301 @@ enum AppState {
 };
 
 AppState currentState = MENU;
+ArcadeGame* activeGame = nullptr; // the running scene, or null in the menu
+
+// Idle rendering. Nobody watches a hidden window, so it is not redrawn at
+// all; a menu left without a key press for a while drops to a trickle of
+// frames, and a game that is paused or over only redraws when it changes.
+const float MENU_IDLE_AFTER = 30.0f; // seconds without a key press
+const int IDLE_FRAME_MS = 100;       // 10 fps
+float lastInputTime = 0.0f;          // frameClock.time() of the last key press
+bool windowVisible = true;
 
 void initializeStars() {
-    srand(time(0));
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].x = (rand() % 2000 - 1000) / 100.0f;
-        stars[i].y = (rand() % 2000 - 1000) / 100.0f;
-        stars[i].z = (rand() % 1000) / -10.0f - 15.0f;
-        stars[i].brightness = (rand() % 100) / 100.0f * 0.5f + 0.5f;
-        stars[i].speed = movementSpeed * (0.5f + stars[i].brightness);
-    }
-}
-
-void updateStars() {
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].z += stars[i].speed;
-        if (stars[i].z > 0.0f) {
-            stars[i].x = (rand() % 2000 - 1000) / 100.0f;
-            stars[i].y = (rand() % 2000 - 1000) / 100.0f;
-            stars[i].z = -15.0f;
-            stars[i].brightness = (rand() % 100) / 100.0f * 0.5f + 0.5f;
-            stars[i].speed = movementSpeed * (0.5f + stars[i].brightness);
-        }
-    }
+    starRng.seed(gameSeed, 0);
+    starfield.init(numStars, -15.0f, movementSpeed, starRng);
 }
 
-void drawStarfield() {
-    glDisable(GL_LIGHTING);
-    glPointSize(2.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < NUM_STARS; ++i) {
-        glColor3f(stars[i].brightness, stars[i].brightness, stars[i].brightness);
-        glVertex3f(stars[i].x, stars[i].y, stars[i].z);
+// Menu lines, placed on a -1..1 canvas over the window. They never change,
+// so they are only laid out again when the window is resized.
+struct MenuLine {
+    float x, y;
+    const char* text;
+};
+const MenuLine MENU_LINES[] = {
+    { -0.4f, 0.6f, "  Welcome to Spaceship Arcade " },
+    { -0.5f, 0.48f, "=================================" },
+    { -0.4f, 0.25f, "Press 1 - Play Flappy Spaceship" },
+    { -0.4f, 0.0f, "Press 2 - Play Spaceship Defender" },
+    { -0.45f, -0.4f, " Press ESC at any time to return to Menu" },
+    { -0.25f, -0.6f, "~ Powered by Pixel ~" },
+};
+const int MENU_LINE_COUNT = sizeof(MENU_LINES) / sizeof(MENU_LINES[0]);
+
+// Each game's best scores, under its menu entry once the leaderboard has loaded
+const MenuLine SCORE_LINES[] = {
+    { -0.35f, 0.15f, flappy::GAME_TITLE },
+    { -0.35f, -0.1f, defender::GAME_TITLE },
+};
+const int SCORE_LINE_COUNT = sizeof(SCORE_LINES) / sizeof(SCORE_LINES[0]);
+const int SCORES_SHOWN = 3;
+std::string scoreTexts[SCORE_LINE_COUNT];
+uint64_t shownScoreRevision = 0;
+
+TextBatch menuText;
+int windowWidth = 800, windowHeight = 600; // kept by reshape()
+
+void initMenuText() {
+    glyphAtlas(GLUT_BITMAP_HELVETICA_18);
+    for (int i = 0; i < MENU_LINE_COUNT; i++) {
+        menuText.addLine(0.84f, 0.84f, 0.84f); // the lit grey the raster text used to pick up
+    }
+    for (int i = 0; i < SCORE_LINE_COUNT; i++) {
+        menuText.setVisible(menuText.addLine(1.0f, 0.85f, 0.3f), false);
     }
-    glEnd();
-    glEnable(GL_LIGHTING);
 }
 
-void drawText(float x, float y, const char* text) {
-    glRasterPos2f(x, y);
-    for (int i = 0; text[i] != '\0'; i++)
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, text[i]);
+// Rebuilds the score lines only when a leaderboard has changed
+void updateScoreTexts() {
+    uint64_t revision = scoreStore().revision();
+    if (revision == shownScoreRevision) return;
+    shownScoreRevision = revision;
+    for (int i = 0; i < SCORE_LINE_COUNT; i++) {
+        std::vector<ScoreEntry> top = scoreStore().leaderboard(SCORE_LINES[i].text);
+        scoreTexts[i] = "Best:";
+        for (int rank = 0; rank < (int)top.size() && rank < SCORES_SHOWN; rank++) {
+            scoreTexts[i] += "  " + std::to_string(top[rank].score);
+        }
+        menuText.setVisible(MENU_LINE_COUNT + i, !top.empty());
+    }
 }
 
-
 void displayMenu() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
     gluLookAt(0, 0, 0, 0, 0, -1, 0, 1, 0);
 
-    updateStars();
-    drawStarfield();
+    starfield.draw();
 
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(-1.0, 1.0, -1.0, 1.0);
+    for (int i = 0; i < MENU_LINE_COUNT; i++) {
+        const MenuLine& line = MENU_LINES[i];
+        menuText.setText(i, (line.x + 1.0f) * 0.5f * windowWidth, (line.y + 1.0f) * 0.5f * windowHeight, line.text);
+    }
+    updateScoreTexts();
+    for (int i = 0; i < SCORE_LINE_COUNT; i++) {
+        const MenuLine& line = SCORE_LINES[i];
+        menuText.setText(MENU_LINE_COUNT + i, (line.x + 1.0f) * 0.5f * windowWidth, (line.y + 1.0f) * 0.5f * windowHeight,
+            scoreTexts[i].c_str());
+    }
+    menuText.draw(windowWidth, windowHeight);
+}
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+void display() {
+    if (activeGame) {
+        activeGame->render(frameClock.alpha(), frameClock.time());
+    }
+    else {
+        displayMenu();
+    }
+    glutSwapBuffers();
+    if (activeGame) activeGame->framePresented();
+}
 
-    drawText(-0.4f, 0.6f, "  Welcome to Spaceship Arcade ");
-    drawText(-0.5f, 0.48f, "=================================");
-    drawText(-0.4f, 0.25f, "Press 1 - Play Flappy Spaceship");
-    drawText(-0.4f, 0.0f, "Press 2 - Play Spaceship Defender");
-    drawText(-0.45f, -0.4f, " Press ESC at any time to return to Menu");
-    drawText(-0.25f, -0.6f, "~ Powered by Pixel ~");
+// Back to the full frame rate after idling
+void wake() {
+    lastInputTime = frameClock.time();
+    glutPostRedisplay();
+}
 
+void timer(int value) {
+    profiler().beginFrame();
+    int ticks = frameClock.beginFrame();
+    if (!activeGame) {
+        // Nothing to simulate here, so the stars just follow real time
+        starfield.advance(frameClock.frameTime());
+    }
+    else if (!simulationThreads) {
+        ProfileZone zone("update");
+        for (int i = 0; i < ticks; i++) {
+            activeGame->update(frameClock.dt());
+        }
+    }
+    if (windowVisible && (!activeGame || activeGame->needsRedraw())) glutPostRedisplay();
+
+    // A game keeps its tick rate even unseen; the menu has nothing to keep up
+    bool menuIdle = !activeGame && (!windowVisible || frameClock.time() - lastInputTime > MENU_IDLE_AFTER);
+    glutTimerFunc(menuIdle ? IDLE_FRAME_MS : frameClock.nextFrameDelayMs(), timer, 0);
+}
 
-    glPopMatrix();
+void visibility(int state) {
+    windowVisible = state == GLUT_VISIBLE;
+    if (windowVisible) wake();
+}
+
+void reshape(int w, int h) {
+    windowWidth = w;
+    windowHeight = h;
+    if (activeGame) {
+        activeGame->reshape(w, h);
+        return;
+    }
+    glViewport(0, 0, w, h);
     glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
+    glLoadIdentity();
+    gluPerspective(60.0, (float)w / h, 0.1, 100);
     glMatrixMode(GL_MODELVIEW);
-
-    glutSwapBuffers();
 }
 
-void display() {
-    if (currentState == MENU)
-        displayMenu();
+// Games share the menu's window and context. Their GL state is pushed on
+// entry and popped on exit so the menu comes back exactly as it was.
+void enterGame(AppState state, ArcadeGame& game) {
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    game.init(fixedSeed ? gameSeed : timeSeed());
+    game.reshape(windowWidth, windowHeight);
+    if (simulationThreads) game.startSimulationThread();
+    activeGame = &game;
+    currentState = state;
+    glutSetWindowTitle(game.title());
 }
 
-void timer(int value) {
-    glutPostRedisplay();
-    glutTimerFunc(16, timer, 0);
+void returnToMenu() {
+    activeGame->shutdown();
+    activeGame = nullptr;
+    currentState = MENU;
+    glPopAttrib();
+    glutSetWindowTitle("Spaceship Menu");
+    reshape(windowWidth, windowHeight);
 }
 
 void keyboard(unsigned char key, int x, int y) {
+    wake();
     if (currentState == MENU) {
         if (key == '1') {
-            system("\"Flappy Spaceship.exe\"");
+            enterGame(FLAPPY, flappy::game());
         }
         else if (key == '2') {
-            system("\"Spaceship Defender.exe\"");
+            enterGame(DEFENDER, defender::game());
+        }
+        else if (key == 27) {
+            exit(0);
         }
     }
     else if (key == 27) {
-        currentState = MENU;
+        returnToMenu();
+    }
+    else {
+        activeGame->keyDown(key);
     }
 }
 
-void reshape(int w, int h) {
-    glViewport(0, 0, w, h);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(60.0, (float)w / h, 0.1, 100);
-    glMatrixMode(GL_MODELVIEW);
+void specialKeys(int key, int x, int y) {
+    wake();
+    if (activeGame) activeGame->specialKeyDown(key);
+}
+
+// Releases go to the game even for keys pressed before it started; games
+// ignore releases of keys they never saw go down
+void keyboardUp(unsigned char key, int x, int y) {
+    if (activeGame) activeGame->keyUp(key);
+}
+
+void specialKeysUp(int key, int x, int y) {
+    if (activeGame) activeGame->specialKeyUp(key);
 }
 
+void setupMenuLighting() {
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+}
+
+// The menu backdrop as a scene of its own, for the render benchmark
+class MenuScene : public ArcadeGame {
+public:
+    const char* title() const override {
+        return "Spaceship Menu";
+    }
+
+    void init(uint64_t seed) override {
+        gameSeed = seed;
+        setupMenuLighting();
+        initializeStars();
+        initMenuText();
+    }
+
+    void update(float deltaTime) override {
+        starfield.advance(deltaTime);
+    }
+
+    void startSimulationThread() override {
+    }
+
+    void render(float alpha, float time) override {
+        displayMenu();
+    }
+
+    void framePresented() override {
+    }
+
+    bool needsRedraw() override {
+        return true;
+    }
+
+    void reshape(int width, int height) override {
+        ::reshape(width, height);
+    }
+
+    void keyDown(unsigned char key) override {
+    }
+
+    void specialKeyDown(int key) override {
+    }
+
+    void keyUp(unsigned char key) override {
+    }
+
+    void specialKeyUp(int key) override {
+    }
+
+    void shutdown() override {
+    }
+};
+
 int main(int argc, char** argv) {
+    numStars = (int)argLong(argc, argv, "--stars", numStars);
+    fixedSeed = argValue(argc, argv, "--seed") != nullptr;
+    gameSeed = argUint64(argc, argv, "--seed", gameSeed);
+    frameClock.setTargetFps(argLong(argc, argv, "--fps", 60));
+    if (const char* tracePath = argValue(argc, argv, "--trace")) startProfilerTrace(tracePath);
+    simulationThreads = !hasArg(argc, argv, "--no-sim-thread");
+    if (hasArg(argc, argv, "--latency")) atexit(defender::reportInputLatency);
+    // Made before any simulation thread can first use it, so it outlives them at exit
+    jobSystem().setThreadCount(argLong(argc, argv, "--threads", jobSystem().threadCount()));
+
+    if (hasArg(argc, argv, "--benchmark")) {
+        MenuScene menu;
+        return runRenderBenchmark(argc, argv, menu);
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutCreateWindow("Spaceship Menu");
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING); 
-    glEnable(GL_LIGHT0);  
-
+    setupMenuLighting();
     initializeStars();
+    initMenuText();
+    scoreStore().open(SCORE_FILE, flappy::GAME_TITLE, flappy::readLegacyHighScore);
+    scoreStore().open(SCORE_FILE, defender::GAME_TITLE, defender::readLegacyHighScore);
 
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);
+    glutSpecialFunc(specialKeys);
+    glutKeyboardUpFunc(keyboardUp);
+    glutSpecialUpFunc(specialKeysUp);
+    glutVisibilityFunc(visibility);
+    glutIgnoreKeyRepeat(1); // held keys are tracked from the down and up events
     glutTimerFunc(0, timer, 0);
 
     glutMainLoop();
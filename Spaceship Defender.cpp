@@ -1,26 +1,53 @@
 #include <GL/glut.h>
 #include <GL/glu.h>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
 #include <stdio.h>
 #include <math.h>
 #include <string>
 #include <vector>
-#include <sstream>
+#include <algorithm>
 #include <fstream>
+#include "ArcadeGame.h"
+#include "CommandLine.h"
+#include "EntityStore.h"
+#include "FrameArena.h"
+#include "FrameCache.h"
+#include "FrameClock.h"
+#include "GlowBatch.h"
+#include "InputLatency.h"
+#include "InstancedRenderer.h"
+#include "JobSystem.h"
+#include "KeyState.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "RenderBenchmark.h"
+#include "RenderQueue.h"
+#include "Replay.h"
+#include "ScoreStore.h"
+#include "SimulationThread.h"
+#include "SpatialGrid.h"
+#include "Starfield.h"
+#include "TextRenderer.h"
+
+namespace defender {
 
 using namespace std;
 
 // ===== Global Variables =====
 float shipX = 0.0f, shipY = -4.0f, shipZ = -15.0f;  // Stationary at bottom
-float shipSpeed = 0.4f;
-float enemySpeed = 0.01f;
+float shipSpeed = 24.0f;        // units per second while an arrow key is held
+float enemySpeed = 0.6f;        // units per second
 float tireRotationAngle = 0.0f;
 
 // Game parameters
 int score = 0;
-int highScore = 0;
+int highScore = 0;          // best this session; the leaderboard keeps the rest
+bool scoreRecorded = false; // this game's score has gone to the leaderboard
 int lives = 3;
 bool gameOver = false;
 bool gamePaused = false;
@@ -28,113 +55,316 @@ float gameTime = 0.0f;
 float spawnTimer = 0.0f;
 float spawnInterval = 3.0f; // Time between enemy spawns
 
+// Controls as the simulation last saw them. A press and release between two
+// ticks still counts for the tick that sees them.
+struct Control {
+    bool held = false;
+    bool pressed = false; // since the last tick
+
+    void set(bool down) {
+        held = down;
+        if (down) pressed = true;
+    }
+
+    bool active() const {
+        return held || pressed;
+    }
+};
+Control moveLeft, moveRight, fire;
+const float FIRE_INTERVAL = 0.15f; // between shotgun blasts while SPACE is held
+float fireCooldown = 0.0f;
+
 // Camera variables (fixed view)
 float camX = 0.0f, camY = 0.0f, camZ = 5.0f;
 float camLookX = 0.0f, camLookY = 0.0f, camLookZ = -15.0f;
 
 // Starfield variables
 const int NUM_STARS = 1000;
-float movementSpeed = 0.1f;
-struct Star {
-    float x, y, z;
-    float brightness;
-    float speed;
-};
-Star stars[NUM_STARS];
-
-// Enemy spaceship variables
-struct Enemy {
-    float x, y, z;
-    float angle;
-    bool active;
-    bool hit;
-    float hitTimer;
-    float speed;
+float movementSpeed = 6.0f; // units per second
+Starfield starfield;
+
+// Simulation runs at a fixed 60 Hz; rendering interpolates between ticks
+FrameClock frameClock(60.0);
+float renderAlpha = 1.0f;  // 0..1 between the previous and current tick
+float renderTime = 0.0f;   // seconds, sampled once per frame
+
+// Random streams, all derived from gameSeed in seedRandom(). Draw code
+// never consumes these; its jitter is hashed from ids and renderFrame.
+uint64_t gameSeed = timeSeed(); // --seed S
+RandomStream starRng;
+RandomStream spawnRng;
+RandomStream enemyRng;
+RandomStream weaponRng;
+RandomStream inputRng; // scripted input in headless runs
+RandomStream effectRng; // explosion debris
+unsigned renderFrame = 0;
+
+// Enemy spaceships, one column per field; see EntityStore.h
+const float ENEMY_Z = -15.0f;
+struct EnemyStore : EntityStore<EnemyStore> {
+    vector<float> x, y;
+    vector<float> prevX, prevY; // position at the previous tick
+    vector<float> angle;
+    vector<float> drift;        // sin(angle), kept so the move loop has no calls
+    vector<float> speed;
+    vector<uint8_t> hit;        // shot this tick; removed at the next
+
+    template <typename Visit>
+    void forEachColumn(Visit visit) {
+        visit(x); visit(y); visit(prevX); visit(prevY); visit(angle); visit(drift); visit(speed); visit(hit);
+    }
+
+    EntityHandle add(float atX, float atY, float withSpeed) {
+        x.push_back(atX);
+        y.push_back(atY);
+        prevX.push_back(atX);
+        prevY.push_back(atY);
+        angle.push_back(0.0f);
+        drift.push_back(0.0f);
+        speed.push_back(withSpeed);
+        hit.push_back(0);
+        return addEntity();
+    }
 };
-vector<Enemy> enemies;
+EnemyStore enemies;
 const int MAX_ENEMIES = 5;
+int maxEnemies = MAX_ENEMIES; // --max-enemies raises this for stress waves
+int waveSize = 1;             // enemies per spawn, --wave-size
+const size_t ENEMY_GRAIN = 2048; // enemies moved per job; smaller waves move inline
+
+// Lasers fly straight up from the ship, at shipZ
+struct LaserStore : EntityStore<LaserStore> {
+    vector<unsigned> id; // seeds the beams' render jitter
+    vector<float> x, y;
+    vector<float> prevY;
+    vector<float> speed;
+
+    template <typename Visit>
+    void forEachColumn(Visit visit) {
+        visit(id); visit(x); visit(y); visit(prevY); visit(speed);
+    }
 
-// Laser variables
-struct Laser {
-    float x, y, z;
-    float speed;
-    bool active;
+    EntityHandle add(unsigned withId, float atX, float atY, float withSpeed) {
+        id.push_back(withId);
+        x.push_back(atX);
+        y.push_back(atY);
+        prevY.push_back(atY);
+        speed.push_back(withSpeed);
+        return addEntity();
+    }
 };
-vector<Laser> lasers;
-float laserSpeed = 1.5f;
-
-// Explosion effects
-struct Explosion {
-    float x, y, z;
-    float size;
-    float time;
-    float maxTime;
+LaserStore lasers;
+const size_t LASER_CAPACITY = 1024; // preallocated, unless a stress wave needs more
+size_t laserCapacity = LASER_CAPACITY;
+unsigned nextLaserId = 0;
+float laserSpeed = 90.0f; // units per second
+
+// Collision broadphase: enemies are binned into HIT_RADIUS-sized cells each
+// tick so a laser only tests the enemies in the cells around it
+const float HIT_RADIUS = 1.0f;
+SpatialGrid enemyGrid(-9.0f, -7.0f, 9.0f, 11.0f, HIT_RADIUS);
+bool useBroadphase = true;   // --no-broadphase tests every pair, for comparison
+long long collisionTests = 0; // narrowphase tests, reported by headless runs
+
+// Explosion effects: every fireball and debris spark is a pooled particle
+const float EXPLOSION_TIME = 0.5f;
+const int EXPLOSION_DEBRIS = 20;
+const size_t MAX_PARTICLES = 32768; // ~1500 simultaneous explosions
+ParticleSystem explosionParticles(MAX_PARTICLES);
+
+// Scores go to the shared leaderboard in SCORE_FILE
+const char* GAME_TITLE = "Space Defender";
+const string LEGACY_HIGH_SCORE_FILE = "highscore.txt"; // imported once
+bool persistHighScore = true; // off for headless runs
+
+// Geometry tessellated once by initMeshes()
+const float ENEMY_SCALE = 0.6f;
+const float FLAME_HEIGHT = 0.4f;
+struct SceneMeshes {
+    LodMesh hull;
+    LodMesh dome;
+    LodMesh sideLight;
+    LodMesh flameGlow;
+    LodMesh flameCone;
+    LodMesh enemyDome;
+    LodMesh enemySideLights; // both lights in one mesh
+    LodMesh enemyFlameGlows;
+    LodMesh enemyFlameCones;
+};
+SceneMeshes meshes;
+InstanceBatch enemyBatches[LOD_LEVELS]; // enemies grouped by the detail they're drawn at
+GlowBatch laserBatch;
+// Each laser is two glow discs, a centre beam and five spread beams
+const size_t LASER_GLOW_VERTICES = 2 * GlowBatch::DISC_VERTICES + 6 * GlowBatch::BEAM_VERTICES;
+
+// drawEnemies() sorts these in the frame arena every frame
+struct VisibleEnemy {
+    float depth; // eye depth
+    size_t index;
 };
-vector<Explosion> explosions;
 
-// High score file
-const string HIGH_SCORE_FILE = "highscore.txt";
+// HUD lines, re-laid-out only when their values change
+TextBatch hud;
+int hudScore, hudHighScore, hudLives, hudGameOver, hudPaused;
+int windowWidth = 800, windowHeight = 600; // kept by reshape()
+
+// Everything render() reads from the simulation, copied after each batch of
+// ticks, so the render thread never reads state the simulation thread is
+// changing
+struct SceneSnapshot {
+    double time = 0.0; // SimulationThread::tickTime() the state is current at
+    float shipX = 0.0f;
+    EnemyStore enemies;
+    LaserStore lasers;
+    ParticleSystem explosions{ MAX_PARTICLES };
+    double starTicks = 0.0;
+    int score = 0, highScore = 0, lives = 3;
+    bool gameOver = false, gamePaused = false;
+    uint32_t inputs = 0;    // tickLatency events its ticks had taken in
+    bool liveInput = true;  // false while a replay drives the ship
+    uint32_t stillFrame = 0; // see stillFrameId()
+};
+SnapshotBuffer<SceneSnapshot> snapshots;
+const SceneSnapshot* scene = nullptr;           // the snapshot render() is drawing
+ParticleSystem explosionSprites(0);             // draws its explosions with the render thread's GL objects
+SimulationThread simulation;                    // unless --no-sim-thread
+SpscQueue<KeyInput, 64> keyPresses;             // from the GLUT callbacks to the next tick
+KeyState keyState;                              // held keys, sampled each tick and latched by render()
+float renderShipX = 0.0f;                       // the ship's latched position this frame
+FrameCache frameCache;                          // the last still frame; see FrameCache.h
+atomic<uint32_t> latestStillFrame{ 0 };         // stillFrame of the newest snapshot
+bool cacheStillFrames = true;                   // off for the render benchmark, which draws every frame
+
+// --latency reports how long inputs take to reach the screen: every input
+// through the simulation's state, and the arrow keys through the ship
+// position render() latches
+InputLatency tickLatency("game state");
+InputLatency moveLatency("ship position (latched)");
+uint32_t appliedInputs = 0;        // tickLatency events taken in by the ticks so far
+uint32_t frameInputs = 0, frameMoves = 0; // what the frame being presented shows
 
 // ===== Function Declarations =====
+void seedRandom(uint64_t seed);
 void initializeStars();
-void spawnEnemy();
+void reserveEntities();
+void initMeshes();
+EntityHandle spawnEnemy();
 void setupLighting();
 void drawSpaceship();
-void drawEnemySpaceship(float x, float y, float z, float angle, bool hit);
-void drawStarfield();
+void drawEnemies();
 void drawText(float x, float y, string text);
+void initHUD();
 void drawHUD();
 void resetGame();
+void stepGame(float deltaTime);
+void moveShip(float direction, float deltaTime);
+float latchedShipX();
 void updateEnemies(float deltaTime);
+EntityHandle addLaser(float x, float y, float speed);
 void fireLaser();
 void updateLasers(float deltaTime);
-void drawLaser(float x, float y, float z);
+void drawLasers();
 void addExplosion(float x, float y, float z);
 void updateExplosions(float deltaTime);
-void drawExplosion(float x, float y, float z, float progress);
 void loadHighScore();
-void saveHighScore();
+void recordScore();
 
-void loadHighScore() {
-    ifstream file(HIGH_SCORE_FILE);
+// The text file the game saved its best score to before the shared score file
+int readLegacyHighScore() {
+    int legacy = 0;
+    ifstream file(LEGACY_HIGH_SCORE_FILE);
     if (file.is_open()) {
-        file >> highScore;
+        file >> legacy;
         file.close();
     }
+    return legacy;
 }
 
-void saveHighScore() {
-    ofstream file(HIGH_SCORE_FILE);
-    if (file.is_open()) {
-        file << highScore;
-        file.close();
-    }
+// Starts loading the leaderboard; it arrives in the background
+void loadHighScore() {
+    if (persistHighScore) scoreStore().open(SCORE_FILE, GAME_TITLE, readLegacyHighScore);
+}
+
+// Hands the current game's score to the leaderboard, once per game. The
+// store saves it on its own thread, so this is safe on the game-over path.
+void recordScore() {
+    if (scoreRecorded) return;
+    scoreRecorded = true;
+    highScore = max(highScore, score);
+    if (persistHighScore) scoreStore().submit(GAME_TITLE, score);
+}
+
+void seedRandom(uint64_t seed) {
+    gameSeed = seed;
+    starRng.seed(seed, 0);
+    spawnRng.seed(seed, 1);
+    enemyRng.seed(seed, 2);
+    weaponRng.seed(seed, 3);
+    inputRng.seed(seed, 4);
+    effectRng.seed(seed, 5);
 }
 
 void initializeStars() {
-    std::srand(std::time(0));
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].x = (std::rand() % 2000 - 1000) / 100.0f;
-        stars[i].y = (std::rand() % 2000 - 1000) / 100.0f;
-        stars[i].z = (std::rand() % 1000) / -10.0f - 15.0f;
-        stars[i].brightness = (std::rand() % 100) / 100.0f * 0.5f + 0.5f;
-        stars[i].speed = movementSpeed * (0.5f + stars[i].brightness);
+    starfield.init(NUM_STARS, -15.0f, movementSpeed, starRng);
+}
+
+// Room for a full wave in the live stores and in every snapshot slot, so
+// steady-state ticks and the copies they publish never allocate
+void reserveEntities() {
+    enemies.reserve(maxEnemies);
+    lasers.reserve(laserCapacity);
+    snapshots.forEachSlot([](SceneSnapshot& snapshot) {
+        snapshot.enemies.reserve(maxEnemies);
+        snapshot.lasers.reserve(laserCapacity);
+    });
+}
+
+// The same for what render() builds from a full wave
+void reserveRenderBatches() {
+    for (InstanceBatch& batch : enemyBatches) batch.reserve(maxEnemies);
+    laserBatch.reserve(laserCapacity * LASER_GLOW_VERTICES);
+}
+
+void initMeshes() {
+    if (meshes.hull.radius > 0.0f) return; // built by an earlier session; composites aren't shared by lookup
+    MeshCache& cache = meshCache();
+    meshes.hull = cache.sphereLod(1.0f, 50, 50);
+    meshes.dome = cache.sphereLod(0.6f, 30, 30);
+    meshes.sideLight = cache.sphereLod(0.15f, 20, 20);
+    meshes.flameGlow = cache.sphereLod(0.2f, 20, 20);
+    meshes.flameCone = cache.coneLod(0.2f, FLAME_HEIGHT, 20, 20);
+    meshes.enemyDome = cache.sphereLod(0.6f * ENEMY_SCALE, 30, 30);
+
+    // Paired enemy parts are merged so each draws once per batch
+    float s = ENEMY_SCALE;
+    meshes.enemySideLights.radius = meshes.enemyFlameGlows.radius = meshes.enemyFlameCones.radius = 2.0f * s;
+    for (int level = 0; level < LOD_LEVELS; ++level) {
+        int slices = lodDivisions(20, level, LOD_MIN_SLICES);
+        int stacks = lodDivisions(20, level, LOD_MIN_STACKS);
+        MeshData light = tessellateSphere(0.15f * s, slices, stacks);
+        MeshData glow = tessellateSphere(0.2f * s, slices, stacks);
+        MeshData cone = tessellateCone(0.2f * s, FLAME_HEIGHT, slices, lodDivisions(20, level, 1));
+        rotateMeshDataX180(cone);
+        MeshData lights, glows, cones;
+        for (float side : { -1.0f, 1.0f }) {
+            appendMeshData(lights, light, 0.9f * side * s, -0.1f * s, 0.2f * s);
+            appendMeshData(glows, glow, 0.6f * side * s, 0.01f * s, 1.7f * s);
+            appendMeshData(cones, cone, 0.6f * side * s, 0.0f, 0.0f);
+        }
+        meshes.enemySideLights.slices[level] = meshes.enemyFlameGlows.slices[level] = meshes.enemyFlameCones.slices[level] = slices;
+        meshes.enemySideLights.levels[level] = &cache.composite(lights);
+        meshes.enemyFlameGlows.levels[level] = &cache.composite(glows);
+        meshes.enemyFlameCones.levels[level] = &cache.composite(cones);
     }
 }
 
-void spawnEnemy() {
-    if (enemies.size() >= MAX_ENEMIES) return;
+// Returns a null handle when the wave is already full
+EntityHandle spawnEnemy() {
+    if (enemies.size() >= (size_t)maxEnemies) return EntityHandle();
 
-    Enemy e;
-    e.x = (rand() % 16) - 8.0f;  // Random X position between -8 and 8
-    e.y = 10.0f;                  // Start above the screen
-    e.z = -15.0f;
-    e.angle = 0.0f;
-    e.active = true;
-    e.hit = false;
-    e.hitTimer = 0.0f;
-    e.speed = enemySpeed + (rand() % 40) / 500.0f; // Random speed
-    enemies.push_back(e);
+    float x = spawnRng.range(16) - 8.0f;  // Random X position between -8 and 8
+    float speed = enemySpeed + spawnRng.range(40) * 0.12f; // Random speed
+    return enemies.add(x, 10.0f, speed); // Start above the screen
 }
 
 void setupLighting() {
@@ -163,54 +393,51 @@ void setupLighting() {
     glLightfv(GL_LIGHT1, GL_SPECULAR, light1_specular);
 }
 
+// The draw functions below queue their geometry; render() draws it sorted
+
 void drawSpaceshipBase() {
+    const float color[4] = { 0.6f, 0.6f, 0.6f, 1.0f };
     glPushMatrix();
-    glColor3f(0.6f, 0.6f, 0.6f);
     glScalef(1.5f, 0.3f, 1.5f);
-    glutSolidSphere(1.0f, 50, 50);
+    renderQueue().add(meshes.hull, color);
     glPopMatrix();
 }
 
 void drawGlassDome() {
+    const float color[4] = { 0.3f, 0.7f, 1.0f, 0.5f };
     glPushMatrix();
     glTranslatef(0.0f, 0.3f, 0.0f);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.3f, 0.7f, 1.0f, 0.5f);
-    glutSolidSphere(0.6f, 30, 30);
-    glDisable(GL_BLEND);
+    renderQueue().add(meshes.dome, color, BLEND_ALPHA);
     glPopMatrix();
 }
 
 void drawSideLights() {
+    const float color[4] = { 1.0f, 0.9f, 0.0f, 1.0f };
     float positions[2] = { -0.9f, 0.9f };
     for (int i = 0; i < 2; i++) {
         glPushMatrix();
         glTranslatef(positions[i], -0.1f, 1.1f - fabs(positions[i]));
-        glColor3f(1.0f, 0.9f, 0.0f);
-        glutSolidSphere(0.15f, 20, 20);
+        renderQueue().add(meshes.sideLight, color);
         glPopMatrix();
     }
 }
 
 void drawThrusterFlame(float offsetX) {
+    const float glowColor[4] = { 1.0f, 0.3f, 0.0f, 0.2f };
+    const float flameColor[4] = { 1.0f, 0.4f, 0.0f, 1.0f };
     glPushMatrix();
     glTranslatef(offsetX, 0.01f, 1.7f);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glColor4f(1.0f, 0.3f, 0.0f, 0.2f);
-    glutSolidSphere(0.2f, 20, 20);
-    glDisable(GL_BLEND);
-    glColor3f(1.0f, 0.4f, 0.0f);
+    renderQueue().add(meshes.flameGlow, glowColor, BLEND_ADDITIVE);
     glRotatef(180, 1, 0, 0);
-    float flameHeight = 0.4f + 0.05f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.001f);
-    glutSolidCone(0.2f, flameHeight, 20, 20);
+    float flameHeight = 0.4f + 0.05f * sin(renderTime);
+    glScalef(1.0f, 1.0f, flameHeight / FLAME_HEIGHT);
+    renderQueue().add(meshes.flameCone, flameColor);
     glPopMatrix();
 }
 
 void drawSpaceship() {
     glPushMatrix();
-    glTranslatef(shipX, shipY, shipZ);
+    glTranslatef(renderShipX, shipY, shipZ);
 
     drawSpaceshipBase();
     drawGlassDome();
@@ -224,424 +451,441 @@ void drawSpaceship() {
 void drawCube(float x, float y, float z, float size) {
     glPushMatrix();
     glTranslatef(x, y, z);
-    glutSolidCube(size);
+    meshCache().cube(size).draw();
     glPopMatrix();
 }
 
 void drawCylinder(float x, float y, float z, float height, float radius) {
-    GLUquadric* quad = gluNewQuadric();
     glPushMatrix();
     glTranslatef(x, y, z);
     glRotatef(-90, 1, 0, 0);
-    gluCylinder(quad, radius, radius, height, 20, 20);
+    glScalef(1.0f, 1.0f, height);
+    meshCache().cylinder(radius, radius, 1.0f, 20, 20).draw();
     glPopMatrix();
-    gluDeleteQuadric(quad);
 }
 
 void drawSphere(float x, float y, float z, float radius) {
     glPushMatrix();
     glTranslatef(x, y, z);
-    glutSolidSphere(radius, 20, 20);
+    meshCache().sphere(radius, 20, 20).draw();
     glPopMatrix();
 }
 
-void drawEnemySpaceshipBase(float scale) {
-    glPushMatrix();
-    glColor3f(0.8f, 0.2f, 0.2f); // Red color for enemy ships
-    glScalef(1.5f * scale, 0.3f * scale, 1.5f * scale);
-    glutSolidSphere(1.0f, 50, 50);
-    glPopMatrix();
-}
+// Enemies share one instance buffer per LOD level, picked from the hull's
+// size on screen; each ship part is then one instanced draw per level in
+// use, regardless of how many enemies are on screen. Instances go in back
+// to front, so the translucent domes composite in order within a level.
+void drawEnemyParts(bool blended) {
+    GpuProfileZone zone(blended ? "enemyGlass" : "enemies");
+    float s = ENEMY_SCALE;
+    const float hullColor[4] = { 0.8f, 0.2f, 0.2f, 1.0f };  // Red color for enemy ships
+    const float lightColor[4] = { 1.0f, 0.0f, 0.0f, 1.0f }; // Red lights
+    const float flameColor[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+    const float domeColor[4] = { 1.0f, 0.3f, 0.3f, 0.5f };  // Red tinted glass
+    const float glowColor[4] = { 1.0f, 0.0f, 0.0f, 0.2f };  // Red flame
+
+    if (!blended) {
+        PartTransform hull;
+        hull.scaleX = 1.5f * s;
+        hull.scaleY = 0.3f * s;
+        hull.scaleZ = 1.5f * s;
+
+        PartTransform flames;
+        flames.offsetY = 0.01f * s;
+        flames.offsetZ = 1.7f * s;
+        float flameHeight = (0.4f + 0.05f * sin(renderTime) * s);
+        flames.scaleZ = flameHeight / FLAME_HEIGHT;
+
+        for (int level = 0; level < LOD_LEVELS; level++) {
+            enemyBatches[level].draw(meshes.hull.level(level), hullColor, hull);
+            enemyBatches[level].draw(meshes.enemySideLights.level(level), lightColor);
+            enemyBatches[level].draw(meshes.enemyFlameCones.level(level), flameColor, flames);
+        }
+        return;
+    }
+
+    PartTransform dome;
+    dome.offsetY = 0.3f * s;
 
-void drawEnemyGlassDome(float scale) {
-    glPushMatrix();
-    glTranslatef(0.0f, 0.3f * scale, 0.0f);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(1.0f, 0.3f, 0.3f, 0.5f); // Red tinted glass
-    glutSolidSphere(0.6f * scale, 30, 30);
-    glDisable(GL_BLEND);
-    glPopMatrix();
-}
-
-void drawEnemySideLights(float scale) {
-    float positions[2] = { -0.9f, 0.9f };
-    for (int i = 0; i < 2; i++) {
-        glPushMatrix();
-        glTranslatef(positions[i] * scale, -0.1f * scale, (1.1f - fabs(positions[i])) * scale);
-        glColor3f(1.0f, 0.0f, 0.0f); // Red lights
-        glutSolidSphere(0.15f * scale, 20, 20);
-        glPopMatrix();
+    for (int level = 0; level < LOD_LEVELS; level++) {
+        enemyBatches[level].draw(meshes.enemyDome.level(level), domeColor, dome);
     }
-}
-
-void drawEnemyThrusterFlame(float offsetX, float scale) {
-    glPushMatrix();
-    glTranslatef(offsetX * scale, 0.01f * scale, 1.7f * scale);
-    glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glColor4f(1.0f, 0.0f, 0.0f, 0.2f); // Red flame
-    glutSolidSphere(0.2f * scale, 20, 20);
+    for (int level = 0; level < LOD_LEVELS; level++) {
+        enemyBatches[level].draw(meshes.enemyFlameGlows.level(level), glowColor);
+    }
     glDisable(GL_BLEND);
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glRotatef(180, 1, 0, 0);
-    float flameHeight = (0.4f + 0.05f * sin(glutGet(GLUT_ELAPSED_TIME) * 0.001f) * scale);
-    glutSolidCone(0.2f * scale, flameHeight, 20, 20);
-    glPopMatrix();
 }
 
-void drawEnemySpaceship(float x, float y, float z, float angle, bool hit) {
-    float scale = 0.6f; // Smaller than player's ship
-
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glRotatef(angle, 0.0f, 1.0f, 0.0f);
-
-    if (hit) {
-        glColor3f(1.0f, 1.0f, 1.0f); // White when hit
+void drawEnemies() {
+    RenderQueue& queue = renderQueue();
+    LodView view = LodView::current();
+    const EnemyStore& enemy = scene->enemies;
+    if (enemy.empty()) return;
+
+    // Eye depth and index of every enemy, farthest first
+    size_t count = enemy.size();
+    VisibleEnemy* visibleEnemies = frameArena().allocate<VisibleEnemy>(count);
+    for (size_t i = 0; i < count; i++) {
+        float x = lerp(enemy.prevX[i], enemy.x[i], renderAlpha), y = lerp(enemy.prevY[i], enemy.y[i], renderAlpha);
+        visibleEnemies[i] = { queue.eyeDepth(x, y, ENEMY_Z), i };
     }
-    else {
-        glColor3f(0.8f, 0.2f, 0.2f); // Red color for enemy ships
+    sort(visibleEnemies, visibleEnemies + count,
+        [](const VisibleEnemy& a, const VisibleEnemy& b) { return a.depth > b.depth; });
+
+    float s = ENEMY_SCALE;
+    float depthSum = 0.0f;
+    for (InstanceBatch& batch : enemyBatches) batch.clear();
+    for (size_t v = 0; v < count; v++) {
+        size_t i = visibleEnemies[v].index;
+        float x = lerp(enemy.prevX[i], enemy.x[i], renderAlpha), y = lerp(enemy.prevY[i], enemy.y[i], renderAlpha);
+        int level = meshes.hull.levelFor(view.pixelRadius(x, y, ENEMY_Z, 1.5f * s));
+        // Hit enemies flash white for the frame before they are removed
+        enemyBatches[level].add(x, y, ENEMY_Z, enemy.angle[i], 1.0f, 1.0f, 1.0f,
+            1.0f, 1.0f, 1.0f, enemy.hit[i] ? 1.0f : 0.0f);
+        depthSum += visibleEnemies[v].depth;
     }
+    for (InstanceBatch& batch : enemyBatches) batch.upload();
 
-    drawEnemySpaceshipBase(scale);
-    drawEnemyGlassDome(scale);
-    drawEnemySideLights(scale);
-    drawEnemyThrusterFlame(-0.6f, scale);
-    drawEnemyThrusterFlame(0.6f, scale);
-
-    glPopMatrix();
+    // Opaque parts go in with the nearest enemy, the glass and glows with the average
+    queue.addBatch([] { drawEnemyParts(false); }, visibleEnemies[count - 1].depth, BLEND_OPAQUE);
+    queue.addBatch([] { drawEnemyParts(true); }, depthSum / count, BLEND_ALPHA);
 }
 
-void drawLaser(float x, float y, float z) {
-    glPushMatrix();
-    glTranslatef(x, y, z);
-
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-
-    // Laser core (bright white)
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-    glutSolidSphere(0.1f, 10, 10);
-
-    // Outer glow (blue)
-    glColor4f(0.2f, 0.2f, 1.0f, 0.5f);
-    glutSolidSphere(0.2f, 10, 10);
-
-    // Draw the laser beam (shotgun spread)
-    glColor4f(0.0f, 0.5f, 1.0f, 0.3f);
-    glRotatef(90, 1.0f, 0.0f, 0.0f);
-    GLUquadric* quad = gluNewQuadric();
-
-    // Main center beam
-    gluCylinder(quad, 0.05f, 0.05f, 5.0f, 10, 10);
-
-    // Additional beams for shotgun effect
-    for (int i = 0; i < 5; i++) {
-        glPushMatrix();
-        float offsetX = (rand() % 100 - 50) / 200.0f;
-        float offsetY = (rand() % 100 - 50) / 200.0f;
-        glTranslatef(offsetX, offsetY, 0);
-        gluCylinder(quad, 0.03f, 0.03f, 3.0f + (rand() % 100) / 100.0f, 8, 8);
-        glPopMatrix();
+// Every laser's glow, core and shotgun beams go into one additive batch
+void drawLasers() {
+    const float coreColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };  // Laser core (bright white)
+    const float glowColor[4] = { 0.2f, 0.2f, 1.0f, 0.5f };  // Outer glow (blue)
+    const float beamColor[4] = { 0.0f, 0.5f, 1.0f, 0.3f };
+
+    laserBatch.begin();
+    const LaserStore& laser = scene->lasers;
+    for (size_t l = 0; l < laser.size(); l++) {
+        float x = laser.x[l];
+        float y = lerp(laser.prevY[l], laser.y[l], renderAlpha);
+        float z = shipZ;
+
+        laserBatch.addDisc(x, y, z, 0.1f, coreColor);
+        laserBatch.addDisc(x, y, z, 0.2f, glowColor);
+
+        // Main center beam trailing below the laser
+        laserBatch.addBeam(x, y, z, x, y - 5.0f, z, 0.05f, beamColor);
+
+        // Additional beams for shotgun effect
+        unsigned id = laser.id[l];
+        for (int i = 0; i < 5; i++) {
+            float offsetX = (hashUnit(id, renderFrame, i * 3) - 0.5f) / 2.0f;
+            float offsetZ = (hashUnit(id, renderFrame, i * 3 + 1) - 0.5f) / 2.0f;
+            float length = 3.0f + hashUnit(id, renderFrame, i * 3 + 2);
+            laserBatch.addBeam(x + offsetX, y, z + offsetZ, x + offsetX, y - length, z + offsetZ, 0.03f, beamColor);
+        }
     }
-
-    gluDeleteQuadric(quad);
-
-    glDisable(GL_BLEND);
-    glEnable(GL_LIGHTING);
-    glPopMatrix();
+    RenderQueue& queue = renderQueue();
+    queue.addBatch([] {
+        GpuProfileZone zone("lasers");
+        laserBatch.draw();
+    }, queue.eyeDepth(0.0f, shipY, shipZ), BLEND_ADDITIVE);
 }
 
-void drawExplosion(float x, float y, float z, float progress) {
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+// Moves enemies [begin, end) through just the columns involved. They never
+// overlap, and __restrict lets the compiler vectorise knowing that.
+void moveEnemies(float* __restrict x, float* __restrict y, float* __restrict prevX, float* __restrict prevY,
+    const float* __restrict drift, const float* __restrict speed, size_t begin, size_t end, float deltaTime) {
+    for (size_t i = begin; i < end; i++) {
+        prevX[i] = x[i];
+        prevY[i] = y[i];
 
-    // Explosion core
-    float coreSize = 0.5f * progress;
-    glColor4f(1.0f, 0.8f, 0.0f, 1.0f);
-    glutSolidSphere(coreSize, 20, 20);
-
-    // Outer explosion
-    float outerSize = 1.0f * progress;
-    glColor4f(1.0f, 0.3f, 0.0f, 1.0f - progress);
-    glutSolidSphere(outerSize, 20, 20);
-
-    // Debris particles
-    glPointSize(3.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 20; i++) {
-        float dist = progress * 2.0f;
-        float px = (rand() % 100 - 50) / 50.0f * dist;
-        float py = (rand() % 100 - 50) / 50.0f * dist;
-        float pz = (rand() % 100 - 50) / 50.0f * dist;
-        float life = 1.0f - progress;
-        glColor4f(1.0f, 0.5f + (rand() % 50) / 100.0f, 0.0f, life);
-        glVertex3f(px, py, pz);
-    }
-    glEnd();
+        // Move enemy downward
+        y[i] -= speed[i] * deltaTime;
 
-    glDisable(GL_BLEND);
-    glEnable(GL_LIGHTING);
-    glPopMatrix();
-}
+        // Apply horizontal movement based on angle
+        x[i] += drift[i] * speed[i] * 0.5f * deltaTime;
 
-void updateStars() {
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].z += stars[i].speed;
-        if (stars[i].z > 0.0f) {
-            stars[i].x = (std::rand() % 2000 - 1000) / 100.0f;
-            stars[i].y = (std::rand() % 2000 - 1000) / 100.0f;
-            stars[i].z = -15.0f;
-            stars[i].brightness = (std::rand() % 100) / 100.0f * 0.5f + 0.5f;
-            stars[i].speed = movementSpeed * (0.5f + stars[i].brightness);
-        }
+        // Keep within bounds
+        x[i] = max(-8.0f, min(8.0f, x[i]));
     }
 }
 
 void updateEnemies(float deltaTime) {
-    for (auto it = enemies.begin(); it != enemies.end(); ) {
-        if (!it->active) {
-            ++it;
-            continue;
+    ProfileZone zone("updateEnemies");
+
+    // Random horizontal movement. The draws come from one stream in enemy
+    // order, so this part stays on one thread.
+    for (size_t i = 0; i < enemies.size(); i++) {
+        if (enemyRng.range(100) < 3) { // 3% chance to change direction
+            enemies.angle[i] = (enemyRng.range(3) - 1) * 30.0f; // -30, 0, or 30 degrees
+            enemies.drift[i] = sin(enemies.angle[i] * 3.14159f / 180.0f);
         }
+    }
 
-        // Move enemy downward
-        it->y -= it->speed;
-
-        // Random horizontal movement
-        if (rand() % 100 < 3) { // 3% chance to change direction
-            it->angle = (rand() % 3 - 1) * 30.0f; // -30, 0, or 30 degrees
-        }
-
-        // Apply horizontal movement based on angle
-        it->x += sin(it->angle * 3.14159f / 180.0f) * it->speed * 0.5f;
-
-        // Keep within bounds
-        it->x = max(-8.0f, min(8.0f, it->x));
+    // Each enemy's move only touches that enemy
+    jobSystem().parallelFor(0, enemies.size(), ENEMY_GRAIN, [deltaTime](size_t begin, size_t end) {
+        moveEnemies(enemies.x.data(), enemies.y.data(), enemies.prevX.data(), enemies.prevY.data(),
+            enemies.drift.data(), enemies.speed.data(), begin, end, deltaTime);
+    });
 
+    // Crashes cost lives and spawn explosions in enemy order. Enemies that
+    // crashed, were shot last tick or left the screen are swapped out as
+    // they are found; the enemy moved into their place is checked next.
+    for (size_t i = 0; i < enemies.size(); ) {
         // Check if enemy reached the bottom (hit spaceship)
-        if (it->y < shipY + 1.0f && !it->hit) {
+        bool crashed = !enemies.hit[i] && enemies.y[i] < shipY + 1.0f;
+        if (crashed) {
             lives--;
-            addExplosion(it->x, it->y, it->z);
-            it->active = false;
+            addExplosion(enemies.x[i], enemies.y[i], ENEMY_Z);
             if (lives <= 0) {
                 gameOver = true;
-                if (score > highScore) {
-                    highScore = score;
-                    saveHighScore();
-                }
+                recordScore();
             }
         }
-
-        // Remove if below screen or hit
-        if (it->y < -6.0f || it->hit) {
-            it = enemies.erase(it);
+        if (crashed || enemies.hit[i] || enemies.y[i] < -6.0f) {
+            enemies.remove(i);
         }
         else {
-            ++it;
+            i++;
         }
     }
 }
 
+EntityHandle addLaser(float x, float y, float speed) {
+    return lasers.add(nextLaserId++, x, y, speed);
+}
+
 void fireLaser() {
     if (gameOver || gamePaused) return;
 
     // Create multiple lasers for shotgun effect
     for (int i = 0; i < 5; i++) {
-        Laser laser;
-        laser.x = shipX + (rand() % 100 - 50) / 100.0f; // Small random spread
-        laser.y = shipY + 1.0f;
-        laser.z = shipZ;
-        laser.speed = laserSpeed * (0.8f + (rand() % 40) / 100.0f); // Slightly random speed
-        laser.active = true;
-        lasers.push_back(laser);
+        float x = shipX + (weaponRng.range(100) - 50) / 100.0f; // Small random spread
+        float speed = laserSpeed * (0.8f + weaponRng.range(40) / 100.0f); // Slightly random speed
+        addLaser(x, shipY + 1.0f, speed);
     }
 }
 
 void updateLasers(float deltaTime) {
-    for (auto it = lasers.begin(); it != lasers.end(); ) {
-        it->y += it->speed;
-
-        bool hit = false;
-
-        // Check collision with enemies
-        for (auto& enemy : enemies) {
-            if (enemy.active && !enemy.hit) {
-                float dx = it->x - enemy.x;
-                float dy = it->y - enemy.y;
-                float distance = sqrt(dx * dx + dy * dy);
-
-                if (distance < 1.0f) { // Hit detection
-                    enemy.hit = true;
-                    score += 10;
-                    addExplosion(enemy.x, enemy.y, enemy.z);
-                    hit = true;
-                    break;
-                }
+    ProfileZone zone("updateLasers");
+    if (lasers.empty()) return;
+
+    // Rebuilt every tick, after updateEnemies() has moved and culled enemies
+    if (useBroadphase) {
+        enemyGrid.build(enemies.size(), enemies.x.data(), enemies.y.data(),
+            [](size_t i) { return !enemies.hit[i]; });
+    }
+
+    float* __restrict laserY = lasers.y.data();
+    float* __restrict laserPrevY = lasers.prevY.data();
+    const float* __restrict laserSpeed = lasers.speed.data();
+    for (size_t l = 0; l < lasers.size(); l++) {
+        laserPrevY[l] = laserY[l];
+        laserY[l] += laserSpeed[l] * deltaTime;
+    }
+
+    for (size_t l = 0; l < lasers.size(); ) {
+        float x = lasers.x[l], y = lasers.y[l];
+
+        // Of the enemies in reach, the one stored first takes the hit.
+        // Returns false once nothing later in the cell can beat `target`.
+        int target = -1;
+        auto test = [&](int index) {
+            if (target >= 0 && index > target) return false;
+            if (enemies.hit[index]) return true;
+            collisionTests++;
+            float dx = x - enemies.x[index];
+            float dy = y - enemies.y[index];
+            if (dx * dx + dy * dy >= HIT_RADIUS * HIT_RADIUS) return true;
+            target = index;
+            return false;
+        };
+        if (useBroadphase) {
+            enemyGrid.forEachNear(x, y, HIT_RADIUS, test);
+        }
+        else {
+            for (int i = 0; i < (int)enemies.size() && test(i); i++) {
             }
         }
 
-        // Remove laser if it hit something or went off screen
-        if (hit || it->y > 10.0f) {
-            it = lasers.erase(it);
+        if (target >= 0) {
+            enemies.hit[target] = 1;
+            score += 10;
+            addExplosion(enemies.x[target], enemies.y[target], ENEMY_Z);
+            lasers.remove(l); // the last laser moves here and is tested next
+        }
+        else if (y > 10.0f) {
+            lasers.remove(l); // went off screen
         }
         else {
-            ++it;
+            l++;
         }
     }
 }
 
 void addExplosion(float x, float y, float z) {
-    Explosion exp;
-    exp.x = x;
-    exp.y = y;
-    exp.z = z;
-    exp.size = 1.0f;
-    exp.time = 0.0f;
-    exp.maxTime = 0.5f;
-    explosions.push_back(exp);
+    // Core and outer fireball, growing to the old sphere sizes
+    ParticleSpawn core;
+    core.x = x; core.y = y; core.z = z;
+    core.life = EXPLOSION_TIME;
+    core.r = 1.0f; core.g = 0.8f; core.b = 0.0f;
+    core.alphaStart = core.alphaEnd = 1.0f;
+    core.sizeStart = 0.0f;
+    core.sizeEnd = 1.0f;
+    explosionParticles.spawn(core);
+
+    ParticleSpawn outer = core;
+    outer.g = 0.3f;
+    outer.alphaEnd = 0.0f;
+    outer.sizeEnd = 2.0f;
+    explosionParticles.spawn(outer);
+
+    // Debris flies out to 2 units on each axis over the explosion's life
+    ParticleSpawn debris = core;
+    debris.alphaEnd = 0.0f;
+    debris.sizeStart = debris.sizeEnd = 0.12f;
+    float reach = 2.0f / EXPLOSION_TIME;
+    for (int i = 0; i < EXPLOSION_DEBRIS; i++) {
+        debris.vx = effectRng.range(-reach, reach);
+        debris.vy = effectRng.range(-reach, reach);
+        debris.vz = effectRng.range(-reach, reach);
+        debris.g = effectRng.range(0.5f, 1.0f);
+        explosionParticles.spawn(debris);
+    }
 }
 
 void updateExplosions(float deltaTime) {
-    for (auto it = explosions.begin(); it != explosions.end(); ) {
-        it->time += deltaTime;
-        if (it->time >= it->maxTime) {
-            it = explosions.erase(it);
-        }
-        else {
-            ++it;
-        }
-    }
+    ProfileZone zone("updateExplosions");
+    explosionParticles.update(deltaTime);
 }
 
-void drawStarfield() {
-    glDisable(GL_LIGHTING);
-    glPointSize(2.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < NUM_STARS; ++i) {
-        glColor3f(stars[i].brightness, stars[i].brightness, stars[i].brightness);
-        glVertex3f(stars[i].x, stars[i].y, stars[i].z);
-    }
-    glEnd();
-    glEnable(GL_LIGHTING);
+void initHUD() {
+    if (hud.lineCount() > 0) return; // set up by an earlier session
+    glyphAtlas(GLUT_BITMAP_HELVETICA_18);
+    hudScore = hud.addLine();
+    hudHighScore = hud.addLine();
+    hudLives = hud.addLine();
+    hudGameOver = hud.addLine(1.0f, 0.0f, 0.0f);
+    hudPaused = hud.addLine(1.0f, 1.0f, 0.0f);
 }
 
 void drawHUD() {
-    // Switch to 2D projection
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    int w = glutGet(GLUT_WINDOW_WIDTH);
-    int h = glutGet(GLUT_WINDOW_HEIGHT);
-    gluOrtho2D(0, w, 0, h);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    // Draw score
-    glColor3f(1.0f, 1.0f, 1.0f);
-    stringstream ss;
-    ss << "Score: " << score;
-    glRasterPos2i(20, h - 30);
-    for (char c : ss.str()) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
-    }
-
-    // Draw high score
-    ss.str("");
-    ss << "High Score: " << highScore;
-    glRasterPos2i(20, h - 60);
-    for (char c : ss.str()) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
-    }
-
-    // Draw lives
-    ss.str("");
-    ss << "Lives: " << lives;
-    glRasterPos2i(20, h - 90);
-    for (char c : ss.str()) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
-    }
-
-    // Draw game over message
-    if (gameOver) {
-        glColor3f(1.0f, 0.0f, 0.0f);
-        string gameOverText = "GAME OVER! Press R to restart";
-        glRasterPos2i(w / 2 - gameOverText.length() * 4, h / 2);
-        for (char c : gameOverText) {
-            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
-        }
-    }
-
-    // Draw pause message
-    if (gamePaused) {
-        glColor3f(1.0f, 1.0f, 0.0f);
-        string pauseText = "PAUSED - Press P to resume";
-        glRasterPos2i(w / 2 - pauseText.length() * 4, h / 2 + 30);
-        for (char c : pauseText) {
-            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
-        }
-    }
-
-    // Restore previous projection
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW); 
+    GpuProfileZone zone("HUD");
+    int w = windowWidth;
+    int h = windowHeight;
+    hud.setNumber(hudScore, 20, h - 30, "Score: ", scene->score);
+    hud.setNumber(hudHighScore, 20, h - 60, "High Score: ", max(scene->highScore, scoreStore().best(GAME_TITLE)));
+    hud.setNumber(hudLives, 20, h - 90, "Lives: ", scene->lives);
+
+    const char* gameOverText = "GAME OVER! Press R to restart";
+    hud.setText(hudGameOver, w / 2 - strlen(gameOverText) * 4.0f, h / 2, gameOverText);
+    hud.setVisible(hudGameOver, scene->gameOver);
+
+    const char* pauseText = "PAUSED - Press P to resume";
+    hud.setText(hudPaused, w / 2 - strlen(pauseText) * 4.0f, h / 2 + 30, pauseText);
+    hud.setVisible(hudPaused, scene->gamePaused);
+
+    hud.draw(w, h);
 }
 
 void resetGame() {
-    if (score > highScore) {
-        highScore = score;
-        saveHighScore();
-    }
+    recordScore(); // a game restarted mid-run still counts
     score = 0;
+    scoreRecorded = false;
     lives = 3;
     gameOver = false;
     gamePaused = false;
     gameTime = 0.0f;
     spawnTimer = 0.0f;
+    moveLeft = moveRight = fire = Control(); // keys still down are pressed again at the next tick
+    fireCooldown = 0.0f;
     enemies.clear();
     lasers.clear();
-    explosions.clear();
+    explosionParticles.clear();
 }
 
-void display() {
+void render(float alpha, float time) {
+    frameArena().reset();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
     gluLookAt(camX, camY, camZ, camLookX, camLookY, camLookZ, 0, 1, 0);
 
-    drawStarfield();
-    drawSpaceship();    
-
-    // Draw all active enemies
-    for (const auto& enemy : enemies) {
-        if (enemy.active && !enemy.hit) {  // Only draw non-hit enemies
-            drawEnemySpaceship(enemy.x, enemy.y, enemy.z, enemy.angle, enemy.hit);
-        }
+    scene = &snapshots.acquire();
+    if (simulation.running()) alpha = simulation.alpha(scene->time);
+    bool still = scene->stillFrame != 0 && !profiler().overlayShown();
+    if (still && frameCache.holds(scene->stillFrame, windowWidth, windowHeight)) {
+        frameCache.draw();
+        return;
     }
 
-    // Draw all active lasers
-    for (const auto& laser : lasers) {
-        drawLaser(laser.x, laser.y, laser.z);
+    // A frozen game has no next state to interpolate toward
+    renderAlpha = (scene->gameOver || scene->gamePaused) ? 1.0f : alpha;
+    frameInputs = scene->inputs;
+    frameMoves = moveLatency.published();
+    renderShipX = latchedShipX();
+    renderTime = time;
+    GpuProfileZone renderZone("render");
+
+    RenderQueue& queue = renderQueue();
+    {
+        ProfileZone zone("submit");
+        queue.begin();
+        queue.addBatch([] {
+            GpuProfileZone zone("starfield");
+            starfield.draw(scene->starTicks);
+        }, queue.eyeDepth(0.0f, 0.0f, -15.0f), BLEND_OPAQUE);
+        drawSpaceship();
+
+        // Draw all active enemies
+        drawEnemies();
+
+        // Draw all active lasers
+        drawLasers();
+
+        // Draw explosions
+        queue.addBatch([] {
+            GpuProfileZone zone("explosions");
+            explosionSprites.draw(scene->explosions, frameClock.dt() * renderAlpha);
+        }, queue.eyeDepth(0.0f, 0.0f, -15.0f), BLEND_ADDITIVE);
     }
-
-    // Draw explosions
-    for (const auto& exp : explosions) {
-        drawExplosion(exp.x, exp.y, exp.z, exp.time / exp.maxTime);
+    {
+        GpuProfileZone zone("scene");
+        queue.flush();
     }
 
     drawHUD();
+    profiler().drawOverlay(windowWidth, windowHeight);
+    if (still) frameCache.capture(scene->stillFrame, windowWidth, windowHeight);
+    renderFrame++;
+}
+
+// False while the frame on screen is a still frame that is still current
+bool needsRedraw() {
+    return profiler().overlayShown()
+        || !frameCache.holds(latestStillFrame.load(memory_order_acquire), windowWidth, windowHeight);
+}
+
+// The frame render() last drew is on screen
+void framePresented() {
+    tickLatency.presented(frameInputs);
+    moveLatency.presented(frameMoves);
+}
 
-    glutSwapBuffers();
+void reportInputLatency() {
+    tickLatency.report();
+    moveLatency.report();
+}
+
+void display() {
+    render(frameClock.alpha(), frameClock.time());
+    {
+        ProfileZone zone("swap");
+        glutSwapBuffers();
+    }
+    framePresented();
 }
 
 void reshape(int width, int height) {
+    windowWidth = width;
+    windowHeight = height;
     glViewport(0, 0, width, height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -649,55 +893,272 @@ void reshape(int width, int height) {
     glMatrixMode(GL_MODELVIEW);
 }
 
-void update(int value) {
-    float deltaTime = 0.016f; // Approximate 60 FPS
+// One simulation tick; no GL or GLUT calls so headless runs can drive it
+void stepGame(float deltaTime) {
+    bool left = moveLeft.active(), right = moveRight.active(), firing = fire.active();
+    moveLeft.pressed = moveRight.pressed = fire.pressed = false;
+    if (gameOver || gamePaused) return;
+
+    moveShip((right ? 1.0f : 0.0f) - (left ? 1.0f : 0.0f), deltaTime);
+    fireCooldown = max(0.0f, fireCooldown - deltaTime);
+    if (firing && fireCooldown <= 0.0f) {
+        fireLaser();
+        fireCooldown = FIRE_INTERVAL;
+    }
 
-    if (!gameOver && !gamePaused) {
-        gameTime += deltaTime;
-        spawnTimer += deltaTime;
+    gameTime += deltaTime;
+    spawnTimer += deltaTime;
 
-        // Spawn new enemies periodically
-        if (spawnTimer >= spawnInterval) {
-            spawnTimer = 0.0f;
+    // Spawn new enemies periodically
+    if (spawnTimer >= spawnInterval) {
+        spawnTimer = 0.0f;
+        for (int i = 0; i < waveSize; i++) {
             spawnEnemy();
-
-            // Increase spawn rate over time
-            spawnInterval = max(0.5f, 2.0f - gameTime / 30.0f);
         }
 
-        tireRotationAngle += 5.0f;
-        if (tireRotationAngle >= 360.0f) tireRotationAngle -= 360.0f;
-
-        updateStars();
-        updateEnemies(deltaTime);
-        updateLasers(deltaTime);
-        updateExplosions(deltaTime);
+        // Increase spawn rate over time
+        spawnInterval = max(0.5f, 2.0f - gameTime / 30.0f);
     }
 
-    glutPostRedisplay();
-    glutTimerFunc(16, update, 0);
+    tireRotationAngle += 300.0f * deltaTime;
+    if (tireRotationAngle >= 360.0f) tireRotationAngle -= 360.0f;
+
+    {
+        ProfileZone zone("updateStars");
+        starfield.advance(deltaTime);
+    }
+    updateEnemies(deltaTime);
+    updateLasers(deltaTime);
+    updateExplosions(deltaTime);
 }
 
-void keyboard(unsigned char key, int x, int y) {
+// ===== Input and replays =====
+// Keys that change the simulation are queued and applied at the start of
+// the next tick, so --record/--replay reproduce a run exactly. The GLUT
+// callbacks pass key presses through keyPresses and the held controls
+// (arrows and SPACE) through keyState; runTick() turns both into inputs on
+// whichever thread runs the simulation.
+
+void applyInput(bool special, int key, bool pressed) {
+    if (special) {
+        switch (key) {
+        case GLUT_KEY_LEFT: moveLeft.set(pressed); break;
+        case GLUT_KEY_RIGHT: moveRight.set(pressed); break;
+        }
+        return;
+    }
+    if (key == ' ') {
+        fire.set(pressed);
+        return;
+    }
+    if (!pressed) return;
     switch (tolower(key)) {
-    case ' ': fireLaser(); break;
     case 'r': resetGame(); break;
     case 'p': gamePaused = !gamePaused; break; // Toggle pause
-    case 27: exit(0); break;
     }
-    glutPostRedisplay();
 }
 
-void specialKeys(int key, int x, int y) {
-    switch (key) {
-    case GLUT_KEY_LEFT: shipX -= shipSpeed; break;
-    case GLUT_KEY_RIGHT: shipX += shipSpeed; break;
+void hashState(StateHash& hash) {
+    hash.add(shipX);
+    hash.add(score);
+    hash.add(lives);
+    hash.add(gameOver);
+    hash.add(gamePaused);
+    hash.add(gameTime);
+    hash.add(spawnTimer);
+    hash.add(spawnInterval);
+    hash.add(moveLeft.held);
+    hash.add(moveRight.held);
+    hash.add(fire.held);
+    hash.add(fireCooldown);
+    for (size_t i = 0; i < enemies.size(); i++) {
+        hash.add(enemies.x[i]);
+        hash.add(enemies.y[i]);
+        hash.add(enemies.hit[i]);
+    }
+    for (size_t l = 0; l < lasers.size(); l++) {
+        hash.add(lasers.x[l]);
+        hash.add(lasers.y[l]);
+    }
+}
+
+InputReplay inputReplay(applyInput, hashState);
+const char* replayPath = nullptr; // --replay FILE
+
+ReplayHeader replayHeader() {
+    ReplayHeader header;
+    header.game = GAME_TITLE;
+    header.seed = gameSeed;
+    header.settings = { (uint32_t)maxEnemies, (uint32_t)waveSize };
+    return header;
+}
+
+// --record FILE or --replay FILE; false if the replay can't be loaded
+bool startReplay(const char* recordPath, const char* playPath) {
+    if (playPath) {
+        ReplayHeader header;
+        if (!inputReplay.startPlayback(playPath, GAME_TITLE, header) || header.settings.size() != 2) return false;
+        replayPath = playPath;
+        gameSeed = header.seed;
+        maxEnemies = (int)header.settings[0];
+        waveSize = (int)header.settings[1];
     }
+    else if (recordPath && inputReplay.startRecording(recordPath, replayHeader())) {
+        atexit([] { inputReplay.stopRecording(); });
+    }
+    return true;
+}
+
+// Queues the presses and releases that bring `control` up to date with
+// keyState; a tap since the last tick becomes a press and release in this one
+void sampleControl(const Control& control, bool special, int key) {
+    bool pressed;
+    bool held = keyState.sample(special ? KeyState::special(key) : key, pressed);
+    if (pressed && control.held) inputReplay.queue(special, key, false); // let go and pressed again
+    if (pressed || held != control.held) inputReplay.queue(special, key, held || pressed);
+    if (pressed && !held) inputReplay.queue(special, key, false);
+}
+
+// One fixed tick with its input; the only way the simulation advances
+void runTick(float deltaTime) {
+    appliedInputs = tickLatency.published(); // everything handed over before now is taken in below
+    KeyInput press;
+    while (keyPresses.pop(press)) inputReplay.queue(press.special, press.key);
+    sampleControl(moveLeft, true, GLUT_KEY_LEFT);
+    sampleControl(moveRight, true, GLUT_KEY_RIGHT);
+    sampleControl(fire, false, ' ');
+    if (inputReplay.finished()) {
+        inputReplay.reportPlayback(replayPath);
+        inputReplay.stopPlayback();
+    }
+    inputReplay.beginTick();
+    stepGame(deltaTime);
+    inputReplay.endTick();
+}
+
+// ===== Simulation thread =====
+
+// Nonzero while nothing on screen can move: the game is paused or over, so
+// the stars, enemies, lasers and explosions all stand still (the flames'
+// flicker and the lasers' shimmer freeze with them). It changes with
+// anything that would make the frame look different.
+uint32_t stillFrameId() {
+    if (!cacheStillFrames || !(gameOver || gamePaused)) return 0;
+    StateHash hash;
+    hash.add(gameTime);
+    hash.add(shipX);
+    hash.add(score);
+    hash.add(highScore);
+    hash.add(lives);
+    hash.add(gameOver);
+    hash.add(gamePaused);
+    return (uint32_t)hash.value() | 1;
+}
+
+// Copies what render() reads into the next snapshot and hands it over
+void publishSnapshot() {
+    SceneSnapshot& snapshot = snapshots.back();
+    snapshot.time = simulation.tickTime();
+    snapshot.shipX = shipX;
+    snapshot.enemies = enemies;
+    snapshot.lasers = lasers;
+    snapshot.explosions.copyFrom(explosionParticles);
+    snapshot.starTicks = starfield.ticks();
+    snapshot.score = score;
+    snapshot.highScore = highScore;
+    snapshot.lives = lives;
+    snapshot.gameOver = gameOver;
+    snapshot.gamePaused = gamePaused;
+    snapshot.inputs = appliedInputs;
+    snapshot.liveInput = !inputReplay.playing();
+    snapshot.stillFrame = stillFrameId();
+    snapshots.publish();
+    latestStillFrame.store(snapshot.stillFrame, memory_order_release);
+}
+
+void stopSimulation() {
+    simulation.stop();
+}
+
+// Moves the ticks off the GLUT thread. The thread is stopped at exit before
+// anything it touches is destroyed.
+void startSimulation() {
+    static bool stopAtExit = false;
+    if (!stopAtExit) {
+        atexit(stopSimulation);
+        stopAtExit = true;
+    }
+    simulation.start(frameClock.dt(), runTick, publishSnapshot);
+}
+
+void update(int value) {
+    profiler().beginFrame();
+    int ticks = frameClock.beginFrame();
+    if (!simulation.running()) {
+        ProfileZone zone("update");
+        for (int i = 0; i < ticks; i++) {
+            runTick(frameClock.dt());
+        }
+        if (ticks > 0) publishSnapshot();
+    }
+
+    if (needsRedraw()) glutPostRedisplay();
+    glutTimerFunc(frameClock.nextFrameDelayMs(), update, 0);
+}
+
+void keyboard(unsigned char key, int x, int y) {
+    if (key == 27) exit(0);
+    if (key == ' ') keyState.press(key); // held to keep firing
+    else keyPresses.push({ false, key });
+    tickLatency.record();
+    glutPostRedisplay();
+}
+
+void keyboardUp(unsigned char key, int x, int y) {
+    if (key != ' ') return;
+    keyState.release(key);
+    tickLatency.record();
+}
+
+void moveShip(float direction, float deltaTime) {
+    shipX += direction * shipSpeed * deltaTime;
     // Keep spaceship within bounds
     shipX = max(-8.0f, min(8.0f, shipX));
+}
+
+bool steers(int key) {
+    return key == GLUT_KEY_LEFT || key == GLUT_KEY_RIGHT;
+}
+
+void specialKeys(int key, int x, int y) {
+    if (key == GLUT_KEY_F3) {
+        profiler().toggleOverlay();
+    }
+    else if (steers(key)) {
+        keyState.press(KeyState::special(key));
+        moveLatency.record();
+        tickLatency.record();
+    }
     glutPostRedisplay();
 }
 
+void specialKeysUp(int key, int x, int y) {
+    if (!steers(key)) return;
+    keyState.release(KeyState::special(key));
+    moveLatency.record();
+    tickLatency.record();
+}
+
+// Render thread: where to draw the ship. The arrow keys held right now
+// carry it on from the snapshot as the next ticks will, so a press or
+// release shows in the next frame instead of after a tick and a snapshot.
+float latchedShipX() {
+    if (!scene->liveInput || scene->gameOver || scene->gamePaused) return scene->shipX;
+    float direction = (keyState.held(KeyState::special(GLUT_KEY_RIGHT)) ? 1.0f : 0.0f)
+        - (keyState.held(KeyState::special(GLUT_KEY_LEFT)) ? 1.0f : 0.0f);
+    return max(-8.0f, min(8.0f, scene->shipX + direction * shipSpeed * frameClock.dt() * renderAlpha));
+}
+
 void init() {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_COLOR_MATERIAL);
@@ -705,30 +1166,295 @@ void init() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     setupLighting();
+    initMeshes();
+    initHUD();
+    seedRandom(gameSeed);
     initializeStars();
+    reserveEntities();
+    reserveRenderBatches();
     loadHighScore();
 
     glClearColor(0.02f, 0.02f, 0.08f, 1.0f);
 }
 
+// ===== Headless simulation =====
+// --headless --ticks N [--seed S] [--input autopilot|random]
+// Runs stepGame() as fast as possible without GLUT or a window, restarting
+// after every game over, and reports simulation throughput.
+//
+// --stress [--max-enemies E] [--lasers L] [--no-broadphase]
+// Instead of playing, keeps E enemies spread over the field and L lasers in
+// flight every tick, with unlimited lives, to measure collision scaling.
+//
+// --stress --scaling [--threads N]
+// Runs the same stress wave with 1, 2, 4... up to N job threads and reports
+// the speedup, along with a hash of the final state that must be the same
+// for every thread count.
+
+// Presses or lets go of a control through the replay stream, as a player would
+void holdControl(const Control& control, bool special, int key, bool hold) {
+    if (control.held != hold) inputReplay.queue(special, key, hold);
+}
+
+// Chases the lowest enemy and holds fire while lined up under it
+void autopilotInput() {
+    int target = -1;
+    for (size_t i = 0; i < enemies.size(); i++) {
+        if (!enemies.hit[i] && (target < 0 || enemies.y[i] < enemies.y[target])) {
+            target = (int)i;
+        }
+    }
+    float dx = target >= 0 ? enemies.x[target] - shipX : 0.0f;
+    float step = shipSpeed * frameClock.dt(); // one tick's movement
+    holdControl(moveLeft, true, GLUT_KEY_LEFT, dx < -step / 2.0f);
+    holdControl(moveRight, true, GLUT_KEY_RIGHT, dx > step / 2.0f);
+    holdControl(fire, false, ' ', target >= 0 && fabs(dx) < 1.0f);
+}
+
+void randomInput() {
+    int move = inputRng.range(3) - 1;
+    holdControl(moveLeft, true, GLUT_KEY_LEFT, move < 0);
+    holdControl(moveRight, true, GLUT_KEY_RIGHT, move > 0);
+    holdControl(fire, false, ' ', inputRng.range(10) == 0);
+}
+
+int benchmarkLasers = 200; // --lasers for --benchmark
+
+void fillStressWave(int laserCount) {
+    while (enemies.size() < (size_t)maxEnemies) {
+        size_t i = enemies.indexOf(spawnEnemy());
+        enemies.y[i] = enemies.prevY[i] = spawnRng.range(-3.0f, 10.0f);
+    }
+    while (lasers.size() < (size_t)laserCount) {
+        float x = weaponRng.range(-8.0f, 8.0f);
+        float y = weaponRng.range(shipY + 1.0f, 10.0f);
+        addLaser(x, y, laserSpeed);
+    }
+    lives = 1 << 30; // the wave is the benchmark; never end the game
+}
+
+int runHeadless(long ticks, bool useRandomInput, int stressLasers) {
+    persistHighScore = false;
+    profiler().enabled = profiler().isTracing();
+    seedRandom(gameSeed);
+    initializeStars();
+    reserveEntities();
+
+    size_t peakEnemies = 0, peakLasers = 0, peakParticles = 0;
+    int gamesPlayed = 1;
+    int bestScore = 0;
+
+    // A replay runs to its end, with all input coming from the file
+    bool replaying = inputReplay.playing();
+    auto start = chrono::steady_clock::now();
+    long tick = 0;
+    for (; replaying ? !inputReplay.finished() : tick < ticks; tick++) {
+        if (stressLasers > 0) {
+            fillStressWave(stressLasers);
+        }
+        else if (!replaying) {
+            // The autopilot holds off until the restart has cleared the field
+            if (gameOver) inputReplay.queue(false, 'r');
+            if (useRandomInput) randomInput();
+            else if (!gameOver) autopilotInput();
+        }
+
+        bool wasOver = gameOver;
+        runTick(frameClock.dt());
+        if (wasOver && !gameOver) gamesPlayed++;
+        bestScore = max(bestScore, score);
+        peakEnemies = max(peakEnemies, enemies.size());
+        peakLasers = max(peakLasers, lasers.size());
+        peakParticles = max(peakParticles, explosionParticles.size());
+    }
+    auto end = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(end - start).count();
+    printf("Spaceship Defender headless: %ld ticks, seed %llu, %s\n",
+        tick, (unsigned long long)gameSeed,
+        stressLasers > 0 ? "stress wave" : replaying ? "replayed input" : useRandomInput ? "random input" : "autopilot input");
+    printf("  ticks/second: %.0f\n", seconds > 0.0 ? tick / seconds : 0.0);
+    printf("  collision tests/tick: %.0f (%s)\n", tick > 0 ? (double)collisionTests / tick : 0.0,
+        useBroadphase ? "grid broadphase" : "all pairs");
+    printf("  peak enemies: %zu, peak lasers: %zu, peak particles: %zu\n", peakEnemies, peakLasers, peakParticles);
+    printf("  games played: %d, best score: %d, final score: %d\n", gamesPlayed, bestScore, score);
+    if (replaying && !inputReplay.reportPlayback(replayPath)) return 1;
+    return 0;
+}
+
+int runScaling(long ticks, int stressLasers, int maxThreads) {
+    persistHighScore = false;
+    profiler().enabled = profiler().isTracing();
+    printf("Spaceship Defender scaling: %ld ticks, seed %llu, %d enemies, %d lasers\n",
+        ticks, (unsigned long long)gameSeed, maxEnemies, stressLasers);
+
+    double baseline = 0.0;
+    bool deterministic = true;
+    uint64_t expected = 0;
+    for (int threads = 1; ; threads = min(threads * 2, maxThreads)) {
+        jobSystem().setThreadCount(threads);
+        seedRandom(gameSeed);
+        initializeStars();
+        reserveEntities();
+        resetGame();
+        shipX = 0.0f;
+        spawnInterval = 3.0f;
+        nextLaserId = 0;
+
+        StateHash hash;
+        auto start = chrono::steady_clock::now();
+        for (long tick = 0; tick < ticks; tick++) {
+            fillStressWave(stressLasers);
+            runTick(frameClock.dt());
+            hashState(hash);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        if (threads == 1) {
+            baseline = seconds;
+            expected = hash.value();
+        }
+        deterministic = deterministic && hash.value() == expected;
+        printf("  %2d threads: %8.0f ticks/second, speedup %.2fx, state %016llx\n", threads,
+            seconds > 0.0 ? ticks / seconds : 0.0, seconds > 0.0 ? baseline / seconds : 0.0, (unsigned long long)hash.value());
+        if (threads == maxThreads) break;
+    }
+    if (!deterministic) printf("  state differs between thread counts\n");
+    return deterministic ? 0 : 1;
+}
+
+// ===== Arcade host interface =====
+
+class DefenderGame : public ArcadeGame {
+public:
+    const char* title() const override {
+        return GAME_TITLE;
+    }
+
+    void init(uint64_t seed) override {
+        gameSeed = seed;
+        defender::init();
+        frameCache.clear();
+        resetGame();
+        publishSnapshot();
+    }
+
+    void update(float deltaTime) override {
+        runTick(deltaTime);
+        publishSnapshot();
+    }
+
+    void startSimulationThread() override {
+        startSimulation();
+    }
+
+    void render(float alpha, float time) override {
+        defender::render(alpha, time);
+    }
+
+    void framePresented() override {
+        defender::framePresented();
+    }
+
+    bool needsRedraw() override {
+        return defender::needsRedraw();
+    }
+
+    void reshape(int width, int height) override {
+        defender::reshape(width, height);
+    }
+
+    void keyDown(unsigned char key) override {
+        keyboard(key, 0, 0);
+    }
+
+    void specialKeyDown(int key) override {
+        specialKeys(key, 0, 0);
+    }
+
+    void keyUp(unsigned char key) override {
+        keyboardUp(key, 0, 0);
+    }
+
+    void specialKeyUp(int key) override {
+        specialKeysUp(key, 0, 0);
+    }
+
+    void shutdown() override {
+        stopSimulation();
+        keyState.clear(); // releases from here on go to the menu
+        recordScore(); // a game left mid-run still counts
+    }
+};
+
+inline ArcadeGame& game() {
+    static DefenderGame instance;
+    return instance;
+}
+
+} // namespace defender
+
+#ifndef SPACESHIP_ARCADE_HOST
 int main(int argc, char** argv) {
+    using namespace defender;
+
+    maxEnemies = max(1L, argLong(argc, argv, "--max-enemies", maxEnemies));
+    waveSize = max(1L, argLong(argc, argv, "--wave-size", waveSize));
+    gameSeed = argUint64(argc, argv, "--seed", gameSeed);
+    useBroadphase = !hasArg(argc, argv, "--no-broadphase");
+    // Made before the simulation thread can first use it, so it outlives that thread at exit
+    jobSystem().setThreadCount(argLong(argc, argv, "--threads", jobSystem().threadCount()));
+    if (const char* tracePath = argValue(argc, argv, "--trace")) startProfilerTrace(tracePath);
+    if (hasArg(argc, argv, "--latency")) atexit(reportInputLatency);
+
+    // Stress waves are placed directly rather than played, so they can't be replayed
+    if (!hasArg(argc, argv, "--stress") && !startReplay(argValue(argc, argv, "--record"), argValue(argc, argv, "--replay"))) return 1;
+
+    // The benchmark scene is a stress wave: --max-enemies enemies and
+    // --lasers lasers kept on screen, with explosions from the hits
+    if (hasArg(argc, argv, "--benchmark")) {
+        persistHighScore = false;
+        cacheStillFrames = false;
+        benchmarkLasers = max(0L, argLong(argc, argv, "--lasers", benchmarkLasers));
+        laserCapacity = max(laserCapacity, (size_t)benchmarkLasers);
+        return runRenderBenchmark(argc, argv, game(), [] { fillStressWave(benchmarkLasers); });
+    }
+
+    if (hasArg(argc, argv, "--headless")) {
+        const char* input = argValue(argc, argv, "--input", "autopilot");
+        int stressLasers = hasArg(argc, argv, "--stress") ? max(1L, argLong(argc, argv, "--lasers", 5000)) : 0;
+        laserCapacity = max(laserCapacity, (size_t)stressLasers);
+        if (stressLasers > 0 && hasArg(argc, argv, "--scaling")) {
+            return runScaling(argLong(argc, argv, "--ticks", 1000), stressLasers, jobSystem().threadCount());
+        }
+        return runHeadless(argLong(argc, argv, "--ticks", 100000), strcmp(input, "random") == 0, stressLasers);
+    }
+
+    frameClock.setTargetFps(argLong(argc, argv, "--fps", 60));
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
-    glutCreateWindow("Space Defender");
+    glutCreateWindow(GAME_TITLE);
 
     init();
+    publishSnapshot();
+    if (!hasArg(argc, argv, "--no-sim-thread")) startSimulation();
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);
     glutSpecialFunc(specialKeys); // Register special key callback
+    glutKeyboardUpFunc(keyboardUp);
+    glutSpecialUpFunc(specialKeysUp);
+    glutIgnoreKeyRepeat(1); // held keys are tracked from the down and up events
     glutTimerFunc(0, update, 0);
 
     printf("=== SPACE DEFENDER ===\n");
     printf("Controls:\n");
     printf("Move: LEFT ARROW (left), RIGHT ARROW (right)\n");
-    printf("Shoot: SPACE (shotgun blast)\n");
+    printf("Shoot: SPACE (shotgun blast; hold to keep firing)\n");
     printf("Pause: P\n");
+    printf("Profiler overlay: F3\n");
     printf("Enemy ships will come at you from above\n");
     printf("Shoot them before they reach you!\n");
     printf("Each hit scores 10 points\n");
@@ -739,3 +1465,4 @@ int main(int argc, char** argv) {
     glutMainLoop();
     return 0;
 }
+#endif
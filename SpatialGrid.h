@@ -0,0 +1,81 @@
+#pragma once
+
+// Uniform grid over the playfield for broadphase collision queries.
+// build() bins item indices by cell with a counting sort: every cell's
+// indices end up contiguous in one array and in ascending order, and a
+// rebuild is two linear passes with no per-cell allocations. Items outside
+// the bounds are clamped into the border cells, so nothing is ever missed.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class SpatialGrid {
+public:
+    SpatialGrid(float minX, float minY, float maxX, float maxY, float cellSize)
+        : minX(minX), minY(minY), invCellSize(1.0f / cellSize) {
+        columns = std::max(1, (int)std::ceil((maxX - minX) * invCellSize));
+        rows = std::max(1, (int)std::ceil((maxY - minY) * invCellSize));
+        cellStart.assign(columns * rows + 1, 0);
+    }
+
+    // Indexes items 0 .. count - 1, at (xs[i], ys[i]), for which include(i) holds
+    template <typename Include>
+    void build(size_t count, const float* xs, const float* ys, Include include) {
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        itemCells.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            int cell = include(i) ? cellOf(xs[i], ys[i]) : -1;
+            itemCells[i] = cell;
+            if (cell >= 0) cellStart[cell]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); c++) {
+            cellStart[c] += cellStart[c - 1]; // now the end of each cell
+        }
+
+        // Filling backwards leaves cellStart at each cell's start and every
+        // cell's indices ascending
+        cellItems.resize(cellStart.back());
+        for (size_t i = count; i-- > 0; ) {
+            if (itemCells[i] >= 0) cellItems[--cellStart[itemCells[i]]] = (int)i;
+        }
+    }
+
+    // Calls visit(index) for the items in the cells overlapping the square
+    // of half-width `radius` around (x, y); the caller does the exact test.
+    // Indices within a cell ascend, and visit returning false skips the rest
+    // of that cell, so a search for the lowest index can stop at its first hit.
+    template <typename Visit>
+    void forEachNear(float x, float y, float radius, Visit visit) const {
+        int x0 = column(x - radius), x1 = column(x + radius);
+        int y0 = row(y - radius), y1 = row(y + radius);
+        for (int r = y0; r <= y1; r++) {
+            for (int c = x0; c <= x1; c++) {
+                int cell = r * columns + c;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    if (!visit(cellItems[k])) break;
+                }
+            }
+        }
+    }
+
+private:
+    float minX, minY;
+    float invCellSize;
+    int columns, rows;
+    std::vector<int> cellStart; // cellItems[cellStart[c] .. cellStart[c + 1]) lie in cell c
+    std::vector<int> cellItems;
+    std::vector<int> itemCells;
+
+    int column(float x) const {
+        return std::min(columns - 1, std::max(0, (int)std::floor((x - minX) * invCellSize)));
+    }
+
+    int row(float y) const {
+        return std::min(rows - 1, std::max(0, (int)std::floor((y - minY) * invCellSize)));
+    }
+
+    int cellOf(float x, float y) const {
+        return row(y) * columns + column(x);
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+// Starfield shared by the menu and both games.
+// Stars live in a static vertex buffer and are animated in the vertex
+// shader: each star's depth is a closed-form function of elapsed time, so
+// advancing the field is O(1) on the CPU and drawing it is one call however
+// many stars there are. Stars fly toward +z and wrap back to farZ when they
+// pass z = 0, picking a fresh x/y for each lap.
+//
+// The clock counts 1/60 s ticks. Speeds are rounded so every star completes
+// a whole number of laps per PERIOD_TICKS; the clock wraps at that period
+// without a visible seam and float precision never degrades on a cabinet
+// left running for days.
+
+#include "GLExtensions.h"
+#include "Random.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class Starfield {
+public:
+    static const int PERIOD_TICKS = 65536;
+    static const int TICKS_PER_SECOND = 60;
+
+    // count stars re-entering at farZ, moving `speed` units per second at
+    // brightness 0.5 (brighter stars are faster, as before)
+    void init(int count, float farZ, float speed, RandomStream& rng) {
+        this->farZ = farZ;
+        clock = 0.0;
+        uploaded = false;
+
+        float depth = -farZ;
+        stars.resize(count);
+        for (StarVertex& star : stars) {
+            star.x = rng.unit();
+            star.y = rng.unit();
+            star.phase = rng.unit();
+            star.brightness = rng.range(0.5f, 1.0f);
+            float ticksPerLap = depth * TICKS_PER_SECOND / (speed * (0.5f + star.brightness));
+            star.laps = std::max(1.0f, std::floor(PERIOD_TICKS / ticksPerLap + 0.5f));
+        }
+    }
+
+    // Moves every star forward by `seconds` of simulated time
+    void advance(float seconds) {
+        clock = std::fmod(clock + seconds * TICKS_PER_SECOND, (double)PERIOD_TICKS);
+    }
+
+    int size() const {
+        return (int)stars.size();
+    }
+
+    // The clock advance() moves, in ticks
+    double ticks() const {
+        return clock;
+    }
+
+    void draw() {
+        draw(clock);
+    }
+
+    // The field as it stood when ticks() returned `atTicks`; a render thread
+    // draws a snapshot of the clock while the simulation advances it
+    void draw(double atTicks) {
+        if (stars.empty()) return;
+        if (!uploaded) upload();
+
+        glDisable(GL_LIGHTING);
+        glPointSize(2.0f);
+        if (program) {
+            drawShader((float)atTicks);
+        }
+        else {
+            drawAnimatedOnCpu((float)atTicks);
+        }
+        glEnable(GL_LIGHTING);
+    }
+
+private:
+    struct StarVertex {
+        float x, y;      // 0..1 across the field, re-hashed every lap
+        float phase;     // 0..1 of the way through the first lap
+        float brightness;
+        float laps;      // whole laps per PERIOD_TICKS
+    };
+
+    enum Attribute { BASE, LAPS };
+
+    std::vector<StarVertex> stars;
+    std::vector<float> cpuVertices; // only used without shader support
+    float farZ = -15.0f;
+    double clock = 0.0;
+    bool uploaded = false; // this field's stars are in the buffer
+    bool created = false;  // the program and buffer, or the lack of support, are settled
+    GLuint buffer = 0;
+    GLuint program = 0;
+    GLint timeUniform = -1;
+    GLint farZUniform = -1;
+
+    // Later init() calls refill the same buffer rather than compiling again
+    void upload() {
+        uploaded = true;
+        if (!created) create();
+        if (!program) return;
+
+        GLExtensions& ext = glExtensions();
+        ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        ext.BufferData(GL_ARRAY_BUFFER, stars.size() * sizeof(StarVertex), stars.data(), GL_STATIC_DRAW);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void create() {
+        created = true;
+        GLExtensions& ext = loadGLExtensions();
+        if (!ext.hasVertexBuffers()) return;
+
+        static const char* vertexSource =
+            "#version 120\n"
+            "attribute vec4 base;\n" // x, y, phase, brightness
+            "attribute float laps;\n"
+            "uniform float time;\n"  // ticks, wrapped at the period
+            "uniform float farZ;\n"
+            "const float PERIOD = 65536.0;\n"
+            "void main() {\n"
+            "    float travel = base.z + laps * time / PERIOD;\n" // in laps
+            "    float lap = floor(travel);\n"
+            "    float z = farZ * (1.0 - (travel - lap));\n"
+            // Additive-recurrence step gives each lap a new, well spread x/y
+            "    vec2 xy = fract(base.xy + lap * vec2(0.7548777, 0.5698403));\n"
+            "    gl_Position = gl_ModelViewProjectionMatrix * vec4(xy * 20.0 - 10.0, z, 1.0);\n"
+            "    gl_FrontColor = vec4(vec3(base.w), 1.0);\n"
+            "}\n";
+        static const char* fragmentSource =
+            "#version 120\n"
+            "void main() { gl_FragColor = gl_Color; }\n";
+        static const char* attributes[] = { "base", "laps" };
+
+        program = compileProgram(vertexSource, fragmentSource, attributes, 2);
+        if (!program) return;
+        timeUniform = ext.GetUniformLocation(program, "time");
+        farZUniform = ext.GetUniformLocation(program, "farZ");
+
+        ext.GenBuffers(1, &buffer);
+    }
+
+    void drawShader(float time) {
+        GLExtensions& ext = glExtensions();
+        ext.UseProgram(program);
+        ext.Uniform1f(timeUniform, time);
+        ext.Uniform1f(farZUniform, farZ);
+
+        ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        ext.EnableVertexAttribArray(BASE);
+        ext.EnableVertexAttribArray(LAPS);
+        ext.VertexAttribPointer(BASE, 4, GL_FLOAT, GL_FALSE, sizeof(StarVertex), (const void*)offsetof(StarVertex, x));
+        ext.VertexAttribPointer(LAPS, 1, GL_FLOAT, GL_FALSE, sizeof(StarVertex), (const void*)offsetof(StarVertex, laps));
+        glDrawArrays(GL_POINTS, 0, (GLsizei)stars.size());
+        ext.DisableVertexAttribArray(LAPS);
+        ext.DisableVertexAttribArray(BASE);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+        ext.UseProgram(0);
+    }
+
+    // Same formula as the shader, evaluated into a client-side array
+    void drawAnimatedOnCpu(float time) {
+        cpuVertices.resize(stars.size() * 6);
+        float* out = cpuVertices.data();
+        for (const StarVertex& star : stars) {
+            float travel = star.phase + star.laps * time / PERIOD_TICKS;
+            float lap = std::floor(travel);
+            float x = star.x + lap * 0.7548777f;
+            float y = star.y + lap * 0.5698403f;
+            *out++ = (x - std::floor(x)) * 20.0f - 10.0f;
+            *out++ = (y - std::floor(y)) * 20.0f - 10.0f;
+            *out++ = farZ * (1.0f - (travel - lap));
+            *out++ = star.brightness;
+            *out++ = star.brightness;
+            *out++ = star.brightness;
+        }
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), cpuVertices.data());
+        glColorPointer(3, GL_FLOAT, 6 * sizeof(float), cpuVertices.data() + 3);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)stars.size());
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+};
@@ -0,0 +1,322 @@
+#pragma once
+
+// Cached HUD text.
+// A GLUT bitmap font is rasterised once into an alpha texture atlas, and
+// TextBatch keeps each line's glyph quads between frames. A line is only
+// re-laid-out when its text, position or colour actually changes, and all
+// visible lines are drawn with a single call from one vertex buffer.
+
+#include "GLExtensions.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// ===== Glyph atlas =====
+
+struct GlyphAtlas {
+    static const int FIRST_CHAR = 32;
+    static const int CHAR_COUNT = 95;  // printable ASCII
+    static const int CELL = 32;        // pixels per glyph cell
+    static const int PAD = 4;          // pen origin inside a cell
+    static const int DESCENT = 8;      // baseline height inside a cell
+    static const int COLUMNS = 16;
+    static const int WIDTH = 512;
+    static const int HEIGHT = 256;
+
+    GLuint texture = 0;
+    int advance[CHAR_COUNT] = {};
+};
+
+#if defined(FREEGLUT) && !defined(GLUT_INIT_STATE)
+#define GLUT_INIT_STATE 0x007C // freeglut_ext.h
+#endif
+
+// GLUT's fonts need glutInit. Offscreen benchmarks without a display run
+// without it and get an empty atlas, so their text draws nothing.
+inline bool glutFontsAvailable() {
+#ifdef FREEGLUT
+    return glutGet(GLUT_INIT_STATE) != 0;
+#else
+    return true;
+#endif
+}
+
+// Draws every glyph with glutBitmapCharacter into the current framebuffer
+// and copies the result out as alpha coverage
+inline void rasterizeGlyphs(void* font, GlyphAtlas& atlas, std::vector<unsigned char>& pixels) {
+    glViewport(0, 0, GlyphAtlas::WIDTH, GlyphAtlas::HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, GlyphAtlas::WIDTH, 0, GlyphAtlas::HEIGHT, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    bool haveFonts = glutFontsAvailable();
+    for (int i = 0; haveFonts && i < GlyphAtlas::CHAR_COUNT; i++) {
+        int c = GlyphAtlas::FIRST_CHAR + i;
+        glRasterPos2i((i % GlyphAtlas::COLUMNS) * GlyphAtlas::CELL + GlyphAtlas::PAD,
+            (i / GlyphAtlas::COLUMNS) * GlyphAtlas::CELL + GlyphAtlas::DESCENT);
+        glutBitmapCharacter(font, c);
+        atlas.advance[i] = glutBitmapWidth(font, c);
+    }
+
+    pixels.resize(GlyphAtlas::WIDTH * GlyphAtlas::HEIGHT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, GlyphAtlas::WIDTH, GlyphAtlas::HEIGHT, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+// One atlas per font, built on first use. Call at startup (after the window
+// exists, before the first frame): without framebuffer objects the glyphs
+// are drawn through the back buffer.
+inline const GlyphAtlas& glyphAtlas(void* font) {
+    static std::map<void*, GlyphAtlas> atlases;
+    auto found = atlases.find(font);
+    if (found != atlases.end()) return found->second;
+    GlyphAtlas& atlas = atlases[font];
+
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    GLExtensions& ext = loadGLExtensions();
+    std::vector<unsigned char> pixels;
+    GLuint framebuffer = 0, target = 0;
+    GLint previousFramebuffer = 0;
+    if (ext.hasFramebuffers()) {
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGenTextures(1, &target);
+        glBindTexture(GL_TEXTURE_2D, target);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, GlyphAtlas::WIDTH, GlyphAtlas::HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        ext.GenFramebuffers(1, &framebuffer);
+        ext.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        ext.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+        if (ext.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            ext.BindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+            ext.DeleteFramebuffers(1, &framebuffer);
+            framebuffer = 0;
+        }
+    }
+    rasterizeGlyphs(font, atlas, pixels);
+    if (framebuffer) {
+        ext.BindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        ext.DeleteFramebuffers(1, &framebuffer);
+    }
+    if (target) glDeleteTextures(1, &target);
+
+    glGenTextures(1, &atlas.texture);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, GlyphAtlas::WIDTH, GlyphAtlas::HEIGHT, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopAttrib();
+    return atlas;
+}
+
+// ===== Text batch =====
+
+class TextBatch {
+public:
+    explicit TextBatch(void* font = GLUT_BITMAP_HELVETICA_18) : font(font) {
+    }
+
+    // Adds a line and returns its handle; lines start empty and visible
+    int addLine(float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+        Line line;
+        line.color[0] = r;
+        line.color[1] = g;
+        line.color[2] = b;
+        lines.push_back(line);
+        return (int)lines.size() - 1;
+    }
+
+    size_t lineCount() const {
+        return lines.size();
+    }
+
+    // Baseline start in window pixels, like glRasterPos in a pixel ortho
+    void setText(int handle, float x, float y, const char* text) {
+        Line& line = lines[handle];
+        if (line.x == x && line.y == y && line.text == text) return;
+        line.x = x;
+        line.y = y;
+        line.text = text;
+        line.dirty = true;
+        dirty = true;
+    }
+
+    // "<prefix><value>", formatted only when the value or position changes
+    void setNumber(int handle, float x, float y, const char* prefix, int value) {
+        Line& line = lines[handle];
+        if (line.hasNumber && line.number == value && line.x == x && line.y == y) return;
+        if (!line.hasNumber) reserve(line, strlen(prefix) + NUMBER_CHARS);
+        line.hasNumber = true;
+        line.number = value;
+        char text[64];
+        snprintf(text, sizeof(text), "%s%d", prefix, value);
+        setText(handle, x, y, text);
+    }
+
+    void setVisible(int handle, bool visible) {
+        if (lines[handle].visible == visible) return;
+        lines[handle].visible = visible;
+        dirty = true;
+    }
+
+    // Width in pixels of `text` in this batch's font
+    int measure(const char* text) {
+        const GlyphAtlas& atlas = glyphAtlas(font);
+        int width = 0;
+        for (const char* c = text; *c; c++) {
+            int glyph = (unsigned char)*c - GlyphAtlas::FIRST_CHAR;
+            if (glyph >= 0 && glyph < GlyphAtlas::CHAR_COUNT) width += atlas.advance[glyph];
+        }
+        return width;
+    }
+
+    // Draws every visible line over a viewport of the given size
+    void draw(int width, int height) {
+        const GlyphAtlas& atlas = glyphAtlas(font);
+        if (dirty) rebuild(atlas);
+        if (vertexCount == 0) return;
+
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0, width, 0, height, -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, atlas.texture);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+        GLExtensions& ext = glExtensions();
+        const float* base = vertices.data();
+        if (buffer) {
+            ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+            base = nullptr;
+        }
+        GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, stride, base);
+        glTexCoordPointer(2, GL_FLOAT, stride, base + 2);
+        glColorPointer(3, GL_FLOAT, stride, base + 4);
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (buffer) ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPopAttrib();
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+
+private:
+    static const int FLOATS_PER_VERTEX = 7; // x, y, u, v, r, g, b
+    static const size_t NUMBER_CHARS = 11; // "-2147483648"
+
+    struct Line {
+        float x = 0.0f, y = 0.0f;
+        float color[3];
+        std::string text;
+        bool visible = true;
+        bool hasNumber = false;
+        int number = 0;
+        bool dirty = true;
+        std::vector<float> quads; // this line's glyphs, laid out at (x, y)
+    };
+
+    void* font;
+    std::vector<Line> lines;
+    std::vector<float> vertices; // all visible lines, as last uploaded
+    GLsizei vertexCount = 0;
+    GLuint buffer = 0;
+    bool dirty = true;
+
+    // Room for `chars` characters, so a number gaining digits never reallocates
+    void reserve(Line& line, size_t chars) {
+        line.text.reserve(chars);
+        line.quads.reserve(chars * 6 * FLOATS_PER_VERTEX);
+    }
+
+    void layout(const GlyphAtlas& atlas, Line& line) {
+        line.quads.clear();
+        float penX = std::floor(line.x + 0.5f);
+        float baseline = std::floor(line.y + 0.5f);
+        for (char ch : line.text) {
+            int glyph = (unsigned char)ch - GlyphAtlas::FIRST_CHAR;
+            if (glyph < 0 || glyph >= GlyphAtlas::CHAR_COUNT) continue;
+
+            float x0 = penX - GlyphAtlas::PAD;
+            float y0 = baseline - GlyphAtlas::DESCENT;
+            float x1 = x0 + GlyphAtlas::CELL;
+            float y1 = y0 + GlyphAtlas::CELL;
+            float u0 = (float)((glyph % GlyphAtlas::COLUMNS) * GlyphAtlas::CELL) / GlyphAtlas::WIDTH;
+            float v0 = (float)((glyph / GlyphAtlas::COLUMNS) * GlyphAtlas::CELL) / GlyphAtlas::HEIGHT;
+            float u1 = u0 + (float)GlyphAtlas::CELL / GlyphAtlas::WIDTH;
+            float v1 = v0 + (float)GlyphAtlas::CELL / GlyphAtlas::HEIGHT;
+
+            const float corners[6][4] = {
+                { x0, y0, u0, v0 }, { x1, y0, u1, v0 }, { x1, y1, u1, v1 },
+                { x0, y0, u0, v0 }, { x1, y1, u1, v1 }, { x0, y1, u0, v1 },
+            };
+            for (const auto& corner : corners) {
+                line.quads.insert(line.quads.end(), { corner[0], corner[1], corner[2], corner[3],
+                    line.color[0], line.color[1], line.color[2] });
+            }
+            penX += atlas.advance[glyph];
+        }
+        line.dirty = false;
+    }
+
+    void rebuild(const GlyphAtlas& atlas) {
+        size_t capacity = 0;
+        for (Line& line : lines) {
+            if (line.dirty) layout(atlas, line);
+            capacity += line.quads.capacity();
+        }
+        vertices.clear();
+        vertices.reserve(capacity);
+        for (const Line& line : lines) {
+            if (line.visible) vertices.insert(vertices.end(), line.quads.begin(), line.quads.end());
+        }
+        vertexCount = (GLsizei)(vertices.size() / FLOATS_PER_VERTEX);
+        dirty = false;
+
+        GLExtensions& ext = loadGLExtensions();
+        if (!ext.hasVertexBuffers() || vertices.empty()) return;
+        if (!buffer) ext.GenBuffers(1, &buffer);
+        ext.BindBuffer(GL_ARRAY_BUFFER, buffer);
+        ext.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+        ext.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};